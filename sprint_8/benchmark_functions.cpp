@@ -0,0 +1,873 @@
+#include "benchmark_functions.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <malloc.h>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "corpus_loader.h"
+#include "load_generator.h"
+#include "process_queries.h"
+#include "read_replica.h"
+#include "score_kernels.h"
+#include "shared_vocabulary.h"
+#include "term_dictionary.h"
+
+using namespace std;
+
+string GenerateWord(mt19937& generator, int max_length) {
+    const int length = uniform_int_distribution(1, max_length)(generator);
+    string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
+    vector<string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob) {
+    string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
+    vector<string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+void AddGeneratedDocuments(SearchServer& search_server, mt19937& generator, const vector<string>& dictionary, int document_count, int max_word_count) {
+    const int first_id = search_server.GetDocumentCount() == 0 ? 0 : *prev(search_server.end()) + 1;
+    for (int i = 0; i < document_count; ++i) {
+        search_server.AddDocument(first_id + i, GenerateQuery(generator, dictionary, max_word_count, 0.0), DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+}
+
+void WriteGeneratedCorpus(const string& path, mt19937& generator, const vector<string>& dictionary, int document_count, int max_word_count) {
+    ofstream out(path);
+    for (int id = 0; id < document_count; ++id) {
+        out << id << '\t' << id % 4 << '\t' << id % 7 << ' ' << id % 5 << '\t'
+            << GenerateQuery(generator, dictionary, max_word_count, 0.0) << '\n';
+    }
+}
+
+// Считает выделения памяти на один запрос: без арены каждое из arena_allocations
+// было бы обращением к глобальной куче, с ареной к куче идут только upstream_allocations
+// и возвращаемый вектор результатов.
+void BenchmarkQueryAllocations() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    SearchServer search_server(dictionary[0]);
+    AddGeneratedDocuments(search_server, generator, dictionary, 10'000, 70);
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 7);
+
+    size_t arena_allocations = 0;
+    size_t arena_bytes = 0;
+    size_t upstream_allocations = 0;
+    const auto start = chrono::steady_clock::now();
+    for (const string& query : queries) {
+        search_server.FindTopDocuments(execution::seq, query);
+        const QueryAllocationStats stats = QueryArena::ForCurrentThread().GetLastQueryStats();
+        arena_allocations += stats.arena_allocations;
+        arena_bytes += stats.arena_bytes;
+        upstream_allocations += stats.upstream_allocations;
+    }
+    const auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+
+    cout << "BenchmarkQueryAllocations: "s << queries.size() << " queries, "s
+         << elapsed.count() / queries.size() << " us/query, "s
+         << "heap allocations per query before: "s << arena_allocations / queries.size() << ", "s
+         << "after: "s << upstream_allocations / queries.size() << " + 1 result vector, "s
+         << "arena bytes per query: "s << arena_bytes / queries.size() << endl;
+}
+
+namespace {
+
+size_t GetResidentBytes() {
+    ifstream statm("/proc/self/statm"s);
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    statm >> total_pages >> resident_pages;
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Прежний путь: построчное чтение в std::string и AddDocument
+size_t LoadCorpusByLines(SearchServer& search_server, const string& path) {
+    ifstream in(path);
+    size_t bytes = 0;
+    for (string line; getline(in, line);) {
+        bytes += line.size() + 1;
+        istringstream fields(line);
+        int id = 0;
+        int status = 0;
+        string ratings_text;
+        string text;
+        fields >> id >> status;
+        fields.ignore();
+        getline(fields, ratings_text, '\t');
+        getline(fields, text);
+        vector<int> ratings;
+        istringstream ratings_stream(ratings_text);
+        for (int rating; ratings_stream >> rating;) {
+            ratings.push_back(rating);
+        }
+        search_server.AddDocument(id, text, static_cast<DocumentStatus>(status), ratings);
+    }
+    return bytes;
+}
+
+void ReportIngest(const string& name, size_t bytes, double seconds, size_t resident_before) {
+    const size_t resident_after = GetResidentBytes();
+    cout << "  "s << name << ": "s << bytes / seconds / 1e6 << " MB/s, RSS +"s
+         << (resident_after > resident_before ? resident_after - resident_before : 0) / (1 << 10) << " KiB"s << endl;
+}
+
+}
+
+// Сравнивает скорость загрузки и прирост RSS трёх путей: построчного чтения,
+// LoadCorpus с копированием слов и LoadCorpus со словами в отображении файла.
+// Каждый путь выполняется в отдельном процессе, чтобы RSS не искажала память,
+// оставшаяся у аллокатора от предыдущего. В RSS последнего пути входят и страницы
+// самого отображения.
+void BenchmarkCorpusIngest() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 12);
+    const string path = (filesystem::temp_directory_path() / "search_server_corpus.tsv"s).string();
+    WriteGeneratedCorpus(path, generator, dictionary, 10'000, 100);
+
+    cout << "BenchmarkCorpusIngest: "s << filesystem::file_size(path) / (1 << 10) << " KiB corpus"s << endl;
+    for (int variant = 0; variant < 3; ++variant) {
+        const pid_t pid = fork();
+        if (pid != 0) {
+            waitpid(pid, nullptr, 0);
+            continue;
+        }
+        const size_t resident_before = GetResidentBytes();
+        SearchServer search_server(dictionary[0]);
+        if (variant == 0) {
+            const auto start = chrono::steady_clock::now();
+            const size_t bytes = LoadCorpusByLines(search_server, path);
+            ReportIngest("getline + AddDocument"s, bytes, chrono::duration<double>(chrono::steady_clock::now() - start).count(), resident_before);
+        } else {
+            CorpusLoadOptions options;
+            options.use_mapped_storage = variant == 2;
+            const CorpusLoadStats stats = LoadCorpus(search_server, path, options);
+            ReportIngest(options.use_mapped_storage ? "LoadCorpus, mapped words"s : "LoadCorpus, copied words"s, stats.bytes, stats.seconds, resident_before);
+        }
+        cout.flush();
+        _exit(0);
+    }
+    remove(path.c_str());
+}
+
+// Скорость добавления документов без журнала, с групповой фиксацией по умолчанию
+// и с fdatasync после каждой записи
+void BenchmarkWriteAheadLog() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    vector<string> documents;
+    for (int i = 0; i < 5'000; ++i) {
+        documents.push_back(GenerateQuery(generator, dictionary, 70));
+    }
+    const string path = (filesystem::temp_directory_path() / "search_server_benchmark.wal"s).string();
+
+    cout << "BenchmarkWriteAheadLog: "s << documents.size() << " documents"s << endl;
+    const vector<pair<string, optional<WriteAheadLogOptions>>> variants = {
+        { "no log"s, nullopt },
+        { "group commit"s, WriteAheadLogOptions{} },
+        { "sync every record"s, WriteAheadLogOptions{ 1, chrono::milliseconds(10) } },
+    };
+    for (const auto& [name, options] : variants) {
+        remove(path.c_str());
+        SearchServer search_server(dictionary[0]);
+        if (options) {
+            search_server.OpenWriteAheadLog(path, *options);
+        }
+        const auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        search_server.SyncWriteAheadLog();
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "  "s << name << ": "s << documents.size() / seconds << " documents/s, "s
+             << search_server.GetWriteAheadLogStats().syncs << " syncs"s << endl;
+    }
+    remove(path.c_str());
+}
+
+namespace {
+
+template <typename Traits>
+void MeasureSearchTraits(const string& name, const string& stop_words, const vector<string>& documents, const vector<string>& queries) {
+    using DocumentId = typename BasicSearchServer<Traits>::DocumentId;
+    const size_t resident_before = GetResidentBytes();
+    BasicSearchServer<Traits> search_server(stop_words);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<DocumentId>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    const size_t resident_after = GetResidentBytes();
+
+    size_t result_count = 0;
+    const auto start = chrono::steady_clock::now();
+    for (const string& query : queries) {
+        result_count += search_server.FindTopDocuments(execution::seq, query).size();
+    }
+    const auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+
+    cout << "  "s << name << ": index RSS +"s << (resident_after - resident_before) / (1 << 10) << " KiB, "s
+         << elapsed.count() / queries.size() << " us/query, "s
+         << sizeof(typename BasicSearchServer<Traits>::Document) << " bytes per result, "s
+         << result_count << " results"s << endl;
+}
+
+}
+
+// Сравнивает память индекса и скорость поиска конфигураций DefaultSearchTraits
+// и CompactSearchTraits; каждая строится в отдельном процессе
+void BenchmarkSearchTraits() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+    vector<string> documents;
+    for (int i = 0; i < 20'000; ++i) {
+        documents.push_back(GenerateQuery(generator, dictionary, 70));
+    }
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 7);
+
+    cout << "BenchmarkSearchTraits: "s << documents.size() << " documents"s << endl;
+    for (int variant = 0; variant < 2; ++variant) {
+        const pid_t pid = fork();
+        if (pid != 0) {
+            waitpid(pid, nullptr, 0);
+            continue;
+        }
+        if (variant == 0) {
+            MeasureSearchTraits<DefaultSearchTraits>("default (int, double)"s, dictionary[0], documents, queries);
+        } else {
+            MeasureSearchTraits<CompactSearchTraits>("compact (uint32_t, float)"s, dictionary[0], documents, queries);
+        }
+        cout.flush();
+        _exit(0);
+    }
+}
+
+namespace {
+
+// Такты процессора там, где их можно прочитать, иначе наносекунды
+uint64_t ReadCycleCounter() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+const char* GetScoreKernelIsaName(ScoreKernelIsa isa) {
+    switch (isa) {
+    case ScoreKernelIsa::AVX2:
+        return "avx2";
+    case ScoreKernelIsa::AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+template <typename Score>
+void MeasureScoreKernels(const string& name, const vector<vector<uint32_t>>& posting_ids, size_t document_count) {
+    vector<vector<Score>> posting_freqs;
+    for (const vector<uint32_t>& ids : posting_ids) {
+        posting_freqs.emplace_back(ids.size(), Score{ 0.25 });
+    }
+    size_t posting_count = 0;
+    for (const vector<uint32_t>& ids : posting_ids) {
+        posting_count += ids.size();
+    }
+
+    cout << "  "s << name << ":"s;
+    for (ScoreKernelIsa isa : { ScoreKernelIsa::SCALAR, ScoreKernelIsa::AVX2, ScoreKernelIsa::AVX512 }) {
+        if (!IsScoreKernelIsaSupported(isa)) {
+            continue;
+        }
+        const ScoreKernels<Score>& kernels = GetScoreKernels<Score>(isa);
+        vector<Score> accumulator(document_count);
+        vector<uint32_t> positions(document_count);
+        const uint64_t start = ReadCycleCounter();
+        for (size_t i = 0; i < posting_ids.size(); ++i) {
+            kernels.accumulate(posting_ids[i].data(), posting_freqs[i].data(), posting_ids[i].size(), Score{ 1.5 }, accumulator.data());
+        }
+        const uint64_t accumulated = ReadCycleCounter();
+        const size_t found = kernels.collect_above(accumulator.data(), accumulator.size(), Score{}, positions.data());
+        const uint64_t collected = ReadCycleCounter();
+        cout << " "s << GetScoreKernelIsaName(isa) << " "s << static_cast<double>(accumulated - start) / posting_count
+             << " per posting + "s << static_cast<double>(collected - accumulated) / document_count << " per document ("s
+             << found << " found);"s;
+    }
+    cout << endl;
+}
+
+}
+
+// Такты на одно вхождение для ядер подсчёта релевантности каждого поддерживаемого
+// набора инструкций и время запроса, которое получается с ними целиком
+void BenchmarkScoreKernels() {
+    constexpr size_t document_count = 1 << 20;
+    mt19937 generator;
+    vector<vector<uint32_t>> posting_ids;
+    for (int term = 0; term < 5; ++term) {
+        vector<uint32_t> ids;
+        for (uint32_t id = 0; id < document_count; ++id) {
+            if (generator() % 8 == 0) {
+                ids.push_back(id);
+            }
+        }
+        posting_ids.push_back(move(ids));
+    }
+
+    cout << "BenchmarkScoreKernels: "s << posting_ids.size() << " terms over "s << document_count << " documents, cycles"s << endl;
+    MeasureScoreKernels<double>("double"s, posting_ids, document_count);
+    MeasureScoreKernels<float>("float"s, posting_ids, document_count);
+
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    SearchServer search_server(dictionary[0]);
+    AddGeneratedDocuments(search_server, generator, dictionary, 50'000, 70);
+    const auto queries = GenerateQueries(generator, dictionary, 200, 7);
+    size_t result_count = 0;
+    const auto start = chrono::steady_clock::now();
+    for (const string& query : queries) {
+        result_count += search_server.FindTopDocuments(execution::seq, query).size();
+    }
+    const auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+    cout << "  end to end, "s << GetScoreKernelIsaName(DetectScoreKernelIsa()) << ": "s << elapsed.count() / queries.size()
+         << " us/query, "s << result_count << " results"s << endl;
+}
+
+namespace {
+
+// Популярность слов запросов убывает степенным образом, а часть запросов повторяется
+// целиком, как в реальном потоке
+vector<string> GenerateSkewedQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count, double repeat_prob) {
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    vector<string> queries;
+    for (int i = 0; i < query_count; ++i) {
+        if (!queries.empty() && unit(generator) < repeat_prob) {
+            queries.push_back(queries[uniform_int_distribution<size_t>(0, queries.size() - 1)(generator)]);
+            continue;
+        }
+        string query;
+        const int word_count = uniform_int_distribution(1, max_word_count)(generator);
+        for (int j = 0; j < word_count; ++j) {
+            const double popularity = unit(generator);
+            const size_t word_index = static_cast<size_t>(popularity * popularity * popularity * dictionary.size());
+            if (!query.empty()) {
+                query.push_back(' ');
+            }
+            query += dictionary[min(word_index, dictionary.size() - 1)];
+        }
+        queries.push_back(move(query));
+    }
+    return queries;
+}
+
+}
+
+// Пропускная способность ProcessQueries и ProcessQueriesShared на пакете запросов
+// с общими словами и повторами
+void BenchmarkBatchQueries() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    SearchServer search_server(dictionary[0]);
+    AddGeneratedDocuments(search_server, generator, dictionary, 50'000, 70);
+    const auto queries = GenerateSkewedQueries(generator, dictionary, 2'000, 5, 0.3);
+
+    cout << "BenchmarkBatchQueries: "s << queries.size() << " queries over 50000 documents"s << endl;
+    for (const auto& [name, process] : { pair{ "ProcessQueries"s, &ProcessQueries }, pair{ "ProcessQueriesShared"s, &ProcessQueriesShared } }) {
+        const auto start = chrono::steady_clock::now();
+        const auto results = process(search_server, queries);
+        const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        size_t result_count = 0;
+        for (const auto& documents : results) {
+            result_count += documents.size();
+        }
+        cout << "  "s << name << ": "s << elapsed.count() << " ms, "s
+             << queries.size() * 1000.0 / max<int64_t>(elapsed.count(), 1) << " queries/s, "s << result_count << " results"s << endl;
+    }
+}
+
+// Задержки под постоянной нагрузкой по расписанию: одиночные запросы без изменений
+// индекса и вместе с потоком добавлений и удалений, затем пакеты ProcessQueries
+void BenchmarkOpenLoopLoad() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    SearchServer search_server(dictionary[0]);
+    AddGeneratedDocuments(search_server, generator, dictionary, 20'000, 70);
+    const auto queries = GenerateZipfQueries(generator, dictionary, 5'000, 5);
+    vector<string> ingest_documents;
+    for (int i = 0; i < 1'000; ++i) {
+        ingest_documents.push_back(GenerateQuery(generator, dictionary, 70));
+    }
+
+    cout << "BenchmarkOpenLoopLoad: 20000 documents, Zipf queries"s << endl;
+    const auto report = [](const string& name, const LoadTestReport& load_report) {
+        cout << "  "s << name << ": "s << load_report.achieved_queries_per_second << " queries/s achieved"s << endl
+             << "    latency from intended send: "s << load_report.latency << endl
+             << "    service time:               "s << load_report.service_time << endl;
+        if (load_report.mutation_latency.count > 0) {
+            cout << "    mutation latency:           "s << load_report.mutation_latency << endl;
+        }
+        cout << "    no result: "s << load_report.no_result_requests << " of "s << load_report.window_requests << endl;
+    };
+
+    LoadTestOptions options;
+    options.queries_per_second = 1'000;
+    options.duration = chrono::milliseconds(3'000);
+    report("1000 qps"s, RunLoadTest(search_server, queries, {}, options));
+    options.mutations_per_second = 100;
+    report("1000 qps + 100 mutations/s"s, RunLoadTest(search_server, queries, ingest_documents, options));
+    options.mutations_per_second = 0;
+    options.batch_size = 50;
+    report("1000 qps in ProcessQueries batches of 50"s, RunLoadTest(search_server, queries, {}, options));
+}
+
+void BenchmarkHighFrequencyTerms() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 5'000, 10);
+    // частоты слов документов и запросов распределены по закону Ципфа
+    const auto documents = GenerateZipfQueries(generator, dictionary, 50'000, 70);
+    SearchServer search_server;
+    for (int id = 0; id < static_cast<int>(documents.size()); ++id) {
+        search_server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, { 1 });
+    }
+    const auto queries = GenerateZipfQueries(generator, dictionary, 2'000, 4);
+
+    cout << "BenchmarkHighFrequencyTerms: "s << queries.size() << " queries over 50000 documents"s << endl;
+    for (const auto& [name, mode] : { pair{ "KEEP"s, HighFrequencyTermMode::KEEP }, pair{ "BITMAP"s, HighFrequencyTermMode::BITMAP },
+                                      pair{ "DROP"s, HighFrequencyTermMode::DROP } }) {
+        search_server.SetHighFrequencyTermOptions({ mode, 0.1, 1'000 });
+        const HighFrequencyTermReport report = search_server.GetHighFrequencyTermReport();
+        const auto start = chrono::steady_clock::now();
+        size_t result_count = 0;
+        for (const string& query : queries) {
+            result_count += search_server.FindTopDocuments(query).size();
+        }
+        const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        cout << "  "s << name << ": "s << report.terms.size() << " terms, "s << report.saved_bytes / 1024 << " KiB saved, "s
+             << elapsed.count() << " ms, "s << result_count << " results"s << endl;
+    }
+}
+
+void BenchmarkRemoveDocuments(int document_count) {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 50'000, 10);
+    SearchServer search_server;
+    AddGeneratedDocuments(search_server, generator, dictionary, document_count, 10);
+    vector<int> removed_ids(search_server.begin(), search_server.end());
+    shuffle(removed_ids.begin(), removed_ids.end(), generator);
+    removed_ids.resize(removed_ids.size() / 10);
+
+    cout << "BenchmarkRemoveDocuments: "s << removed_ids.size() << " of "s << document_count << " documents"s << endl;
+    // каждый вариант удаляет из своей копии индекса в дочернем процессе
+    for (int variant = 0; variant < 3; ++variant) {
+        const pid_t pid = fork();
+        if (pid != 0) {
+            waitpid(pid, nullptr, 0);
+            continue;
+        }
+        const auto start = chrono::steady_clock::now();
+        if (variant == 0) {
+            for (const int document_id : removed_ids) {
+                search_server.RemoveDocument(document_id);
+            }
+        } else if (variant == 1) {
+            search_server.RemoveDocuments(execution::seq, removed_ids);
+        } else {
+            search_server.RemoveDocuments(execution::par, removed_ids);
+        }
+        const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        const string name = variant == 0 ? "RemoveDocument loop"s : variant == 1 ? "RemoveDocuments(seq)"s : "RemoveDocuments(par)"s;
+        cout << "  "s << name << ": "s << elapsed.count() << " ms, "s << search_server.GetDocumentCount() << " documents left"s << endl;
+        cout.flush();
+        _exit(0);
+    }
+}
+
+// Добавления после удалений: документ со свежим номером дописывается в конец списков
+// своих слов, а с переиспользованным встаёт в их середину
+void BenchmarkDocumentChurn(int document_count) {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    SearchServer search_server;
+    AddGeneratedDocuments(search_server, generator, dictionary, document_count, 10);
+    vector<int> removed_ids(search_server.begin(), search_server.end());
+    shuffle(removed_ids.begin(), removed_ids.end(), generator);
+    removed_ids.resize(removed_ids.size() / 10);
+    search_server.RemoveDocuments(removed_ids);
+    vector<string> added_documents;
+    for (size_t i = 0; i < removed_ids.size(); ++i) {
+        added_documents.push_back(GenerateQuery(generator, dictionary, 10, 0.0));
+    }
+
+    cout << "BenchmarkDocumentChurn: "s << added_documents.size() << " adds after removing as many of "s << document_count << " documents"s << endl;
+    // каждый вариант добавляет в свою копию индекса в дочернем процессе
+    for (const bool reuse : { false, true }) {
+        const pid_t pid = fork();
+        if (pid != 0) {
+            waitpid(pid, nullptr, 0);
+            continue;
+        }
+        search_server.SetOrdinalReuse(reuse);
+        const int first_id = document_count;
+        const auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < added_documents.size(); ++i) {
+            search_server.AddDocument(first_id + static_cast<int>(i), added_documents[i], DocumentStatus::ACTUAL, { 1 });
+        }
+        const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        cout << "  "s << (reuse ? "reused ordinals"s : "fresh ordinals"s) << ": "s << elapsed.count() << " ms, "s
+             << search_server.GetDocumentCount() << " documents"s << endl;
+        cout.flush();
+        _exit(0);
+    }
+}
+
+void BenchmarkTermDictionary() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 100'000, 10);
+    map<string_view, int> word_to_term_id;
+    TermDictionary term_dictionary;
+    for (const string& word : dictionary) {
+        if (term_dictionary.Find(word) == TermDictionary::NOT_FOUND) {
+            const int term_id = static_cast<int>(word_to_term_id.size());
+            word_to_term_id.emplace(word, term_id);
+            term_dictionary.Insert(word, TermDictionary::Hash(word), term_id);
+        }
+    }
+    // половина искомых слов в словаре, половина — нет
+    vector<string> lookups;
+    for (int i = 0; i < 2'000'000; ++i) {
+        lookups.push_back(i % 2 == 0 ? dictionary[generator() % dictionary.size()] : GenerateWord(generator, 10) + "#"s);
+    }
+
+    cout << "BenchmarkTermDictionary: "s << lookups.size() << " lookups over "s << term_dictionary.size() << " terms"s << endl;
+    const auto measure = [&lookups](const string& name, const auto& find) {
+        const auto start = chrono::steady_clock::now();
+        int64_t checksum = 0;
+        for (const string& word : lookups) {
+            checksum += find(word);
+        }
+        const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        cout << "  "s << name << ": "s << elapsed.count() << " ms, checksum "s << checksum << endl;
+    };
+    measure("std::map"s, [&word_to_term_id](string_view word) {
+        const auto it = word_to_term_id.find(word);
+        return it == word_to_term_id.end() ? TermDictionary::NOT_FOUND : it->second;
+    });
+    measure("TermDictionary"s, [&term_dictionary](string_view word) {
+        return term_dictionary.Find(word);
+    });
+}
+
+void BenchmarkQueryProfile() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+    SearchServer search_server;
+    AddGeneratedDocuments(search_server, generator, dictionary, 100'000, 50);
+    const auto queries = GenerateQueries(generator, dictionary, 2'000, 7);
+    const DocumentFilter filter{ DocumentStatus::ACTUAL };
+
+    cout << "BenchmarkQueryProfile: "s << queries.size() << " queries over 100000 documents"s << endl;
+    {
+        const auto start = chrono::steady_clock::now();
+        size_t result_count = 0;
+        for (const string& query : queries) {
+            result_count += search_server.FindTopDocuments(execution::seq, query, filter).size();
+        }
+        const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        cout << "  without profile: "s << elapsed.count() << " ms, "s << result_count << " results"s << endl;
+    }
+    {
+        QueryProfile profile;
+        QueryProfile slowest_profile;
+        const auto start = chrono::steady_clock::now();
+        size_t result_count = 0;
+        for (const string& query : queries) {
+            result_count += search_server.FindTopDocuments(execution::seq, query, filter, profile).size();
+            if (profile.score_time > slowest_profile.score_time) {
+                slowest_profile = profile;
+            }
+        }
+        const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        cout << "  with profile: "s << elapsed.count() << " ms, "s << result_count << " results"s << endl;
+        cout << "  slowest: "s << slowest_profile << endl;
+    }
+}
+
+void BenchmarkSharedVocabulary() {
+    constexpr int instance_count = 50;
+    mt19937 generator;
+    // словари экземпляров совпадают примерно на 80%
+    const auto common_dictionary = GenerateDictionary(generator, 20'000, 10);
+    vector<vector<string>> corpora(instance_count);
+    for (vector<string>& corpus : corpora) {
+        const auto own_dictionary = GenerateDictionary(generator, 5'000, 10);
+        for (int i = 0; i < 2'000; ++i) {
+            string document;
+            for (int j = 0; j < 20; ++j) {
+                const auto& dictionary = generator() % 5 == 0 ? own_dictionary : common_dictionary;
+                document += dictionary[generator() % dictionary.size()] + " "s;
+            }
+            corpus.push_back(move(document));
+        }
+    }
+
+    cout << "BenchmarkSharedVocabulary: "s << instance_count << " instances, 2000 documents each"s << endl;
+    for (const bool is_shared : { false, true }) {
+        // крупные блоки выделяются через mmap и учитываются в hblkhd
+        const auto heap_usage = [] {
+            const struct mallinfo2 info = mallinfo2();
+            return info.uordblks + info.hblkhd;
+        };
+        const size_t heap_before = heap_usage();
+        const auto start = chrono::steady_clock::now();
+        auto vocabulary = is_shared ? make_shared<SharedVocabulary>() : nullptr;
+        vector<unique_ptr<SearchServer>> servers;
+        for (const vector<string>& corpus : corpora) {
+            servers.push_back(make_unique<SearchServer>());
+            if (vocabulary) {
+                servers.back()->SetSharedVocabulary(vocabulary);
+            }
+            for (int id = 0; id < static_cast<int>(corpus.size()); ++id) {
+                servers.back()->AddDocument(id, corpus[id], DocumentStatus::ACTUAL, { 1 });
+            }
+        }
+        const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        const size_t heap_bytes = heap_usage() - heap_before;
+        cout << "  "s << (is_shared ? "shared vocabulary"s : "own vocabularies"s) << ": "s << heap_bytes / (1024 * 1024) << " MiB, "s
+             << elapsed.count() << " ms"s;
+        if (vocabulary) {
+            cout << ", "s << vocabulary->size() << " words in the shared vocabulary"s;
+        }
+        cout << endl;
+    }
+}
+
+void BenchmarkLongQueries() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 10);
+    const auto documents = GenerateZipfQueries(generator, dictionary, 50'000, 70);
+    SearchServer search_server;
+    for (int id = 0; id < static_cast<int>(documents.size()); ++id) {
+        search_server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, { 1 });
+    }
+    const auto queries = GenerateZipfQueries(generator, dictionary, 200, 1'000);
+
+    // доля документов точного результата, найденных и сокращённым запросом
+    const auto compute_recall = [](const vector<vector<Document>>& exact_results, const vector<vector<Document>>& results) {
+        size_t exact_count = 0;
+        size_t found_count = 0;
+        for (size_t i = 0; i < results.size(); ++i) {
+            for (const Document& exact_document : exact_results[i]) {
+                ++exact_count;
+                found_count += any_of(results[i].begin(), results[i].end(), [&exact_document](const Document& document) {
+                    return document.id == exact_document.id;
+                });
+            }
+        }
+        return exact_count == 0 ? 1.0 : found_count * 1.0 / exact_count;
+    };
+    const auto measure = [&search_server, &compute_recall](const string& name, const auto& search) {
+        vector<vector<Document>> exact_results;
+        for (const size_t max_terms : { size_t{ 0 }, size_t{ 64 }, size_t{ 16 } }) {
+            search_server.SetLongQueryOptions({ max_terms, 0.0 });
+            const auto start = chrono::steady_clock::now();
+            const vector<vector<Document>> results = search();
+            const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+            if (exact_results.empty()) {
+                exact_results = results;
+            }
+            cout << "  "s << name << ", max_terms = "s << max_terms << ": "s << elapsed.count() << " ms, recall "s
+                 << compute_recall(exact_results, results) << endl;
+        }
+    };
+
+    cout << "BenchmarkLongQueries: 200 queries of up to 1000 words and 200 FindSimilar over 50000 documents"s << endl;
+    measure("FindTopDocuments"s, [&search_server, &queries] {
+        vector<vector<Document>> results;
+        for (const string& query : queries) {
+            results.push_back(search_server.FindTopDocuments(query));
+        }
+        return results;
+    });
+    measure("FindSimilar"s, [&search_server] {
+        vector<vector<Document>> results;
+        for (int id = 0; id < 200; ++id) {
+            results.push_back(search_server.FindSimilar(id));
+        }
+        return results;
+    });
+    search_server.SetLongQueryOptions({});
+}
+
+void BenchmarkStandingQueries() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 10);
+    const auto documents = GenerateZipfQueries(generator, dictionary, 60'000, 70);
+    const auto queries = GenerateZipfQueries(generator, dictionary, 20'000, 4);
+    SearchServer search_server;
+    for (int id = 0; id < 50'000; ++id) {
+        search_server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, { 1 });
+    }
+    for (int query_id = 0; query_id < static_cast<int>(queries.size()); ++query_id) {
+        search_server.AddStandingQuery(query_id, queries[query_id]);
+    }
+
+    cout << "BenchmarkStandingQueries: "s << queries.size() << " standing queries, 10000 documents added to 50000"s << endl;
+    size_t match_count = 0;
+    search_server.SetStandingQueryCallback([&match_count](int, const vector<StandingQueryMatch>& matches) {
+        match_count += matches.size();
+    });
+    const auto start = chrono::steady_clock::now();
+    for (int id = 50'000; id < static_cast<int>(documents.size()); ++id) {
+        search_server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, { 1 });
+    }
+    const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    cout << "  percolator: "s << elapsed.count() << " ms, "s << 10'000 * 1000 / max<int64_t>(elapsed.count(), 1) << " documents/s, "s
+         << match_count << " matches"s << endl;
+
+    // без перколятора после каждого документа заново выполняются все сохранённые запросы
+    const auto rerun_start = chrono::steady_clock::now();
+    for (const string& query : queries) {
+        search_server.FindTopDocuments(query);
+    }
+    const auto rerun_elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - rerun_start);
+    cout << "  rerunning all queries: "s << rerun_elapsed.count() << " ms per added document"s << endl;
+}
+
+void BenchmarkReadReplicas() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 10);
+    const auto documents = GenerateZipfQueries(generator, dictionary, 30'000, 70);
+    const auto queries = GenerateZipfQueries(generator, dictionary, 3'000, 4);
+    const string socket_path = (filesystem::temp_directory_path() / "search_server_benchmark.sock"s).string();
+    const int replica_count = 3;
+
+    cout << "BenchmarkReadReplicas: "s << documents.size() << " documents, "s << replica_count << " replicas"s << endl;
+    {
+        SearchServer search_server;
+        const auto start = chrono::steady_clock::now();
+        for (int id = 0; id < static_cast<int>(documents.size()); ++id) {
+            search_server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, { 1 });
+        }
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "  writer without publisher: "s << documents.size() / seconds << " documents/s"s << endl;
+    }
+
+    SearchServer writer;
+    writer.OpenMutationPublisher(socket_path);
+    vector<unique_ptr<SearchServer>> replica_servers;
+    vector<unique_ptr<ReadReplica<DefaultSearchTraits>>> replicas;
+    for (int i = 0; i < replica_count; ++i) {
+        replica_servers.push_back(make_unique<SearchServer>());
+        replicas.push_back(make_unique<ReadReplica<DefaultSearchTraits>>(*replica_servers.back(), socket_path));
+    }
+
+    // пока пишущий сервер добавляет документы, каждая реплика в своём потоке отвечает на
+    // запросы, требуя изменений не старше уже опубликованных к началу запроса
+    atomic<bool> is_writing = true;
+    atomic<size_t> read_count = 0;
+    vector<thread> readers;
+    for (int i = 0; i < replica_count; ++i) {
+        readers.emplace_back([&, i] {
+            for (size_t q = 0; is_writing; ++q) {
+                replicas[i]->Read(writer.GetMutationSequence(), chrono::seconds(10), [&](const SearchServer& server) {
+                    return server.FindTopDocuments(queries[q % queries.size()]);
+                });
+                ++read_count;
+            }
+        });
+    }
+    const auto start = chrono::steady_clock::now();
+    for (int id = 0; id < static_cast<int>(documents.size()); ++id) {
+        writer.AddDocument(id, documents[id], DocumentStatus::ACTUAL, { 1 });
+    }
+    const auto written = chrono::steady_clock::now();
+    const uint64_t last_sequence = writer.GetMutationSequence();
+    for (const auto& replica : replicas) {
+        replica->WaitForSequence(last_sequence, chrono::seconds(60));
+    }
+    const auto replicated = chrono::steady_clock::now();
+    is_writing = false;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    const double write_seconds = chrono::duration<double>(written - start).count();
+    cout << "  writer with publisher: "s << documents.size() / write_seconds << " documents/s, "s
+         << writer.GetMutationPublisherStats().bytes_sent / (1 << 20) << " MiB sent"s << endl;
+    cout << "  replicas caught up "s << chrono::duration_cast<chrono::milliseconds>(replicated - written).count()
+         << " ms after the last write, "s << read_count / write_seconds << " reads/s during ingestion"s << endl;
+
+    size_t mismatch_count = 0;
+    for (size_t q = 0; q < 300; ++q) {
+        const auto expected = writer.FindTopDocuments(queries[q]);
+        for (const auto& replica : replicas) {
+            const auto found = replica->Read(last_sequence, chrono::seconds(1), [&](const SearchServer& server) {
+                return server.FindTopDocuments(queries[q]);
+            });
+            mismatch_count += found.size() != expected.size()
+                || !equal(found.begin(), found.end(), expected.begin(), [](const Document& lhs, const Document& rhs) { return lhs.id == rhs.id; });
+        }
+    }
+    cout << "  "s << mismatch_count << " of "s << 300 * replica_count << " replica answers differ from the writer"s << endl;
+}
+
+void RunBenchmarks() {
+    BenchmarkQueryAllocations();
+    BenchmarkCorpusIngest();
+    BenchmarkWriteAheadLog();
+    BenchmarkSearchTraits();
+    BenchmarkScoreKernels();
+    BenchmarkBatchQueries();
+    BenchmarkOpenLoopLoad();
+    BenchmarkHighFrequencyTerms();
+    BenchmarkRemoveDocuments();
+    BenchmarkDocumentChurn();
+    BenchmarkTermDictionary();
+    BenchmarkQueryProfile();
+    BenchmarkSharedVocabulary();
+    BenchmarkLongQueries();
+    BenchmarkStandingQueries();
+    BenchmarkReadReplicas();
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+std::string GenerateWord(std::mt19937& generator, int max_length);
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length);
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count, double minus_prob = 0);
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary, int query_count, int max_word_count);
+void AddGeneratedDocuments(SearchServer& search_server, std::mt19937& generator, const std::vector<std::string>& dictionary, int document_count, int max_word_count);
+void WriteGeneratedCorpus(const std::string& path, std::mt19937& generator, const std::vector<std::string>& dictionary, int document_count, int max_word_count);
+
+void BenchmarkQueryAllocations();
+void BenchmarkCorpusIngest();
+void BenchmarkWriteAheadLog();
+void BenchmarkSearchTraits();
+void BenchmarkScoreKernels();
+void BenchmarkBatchQueries();
+void BenchmarkOpenLoopLoad();
+void BenchmarkHighFrequencyTerms();
+void BenchmarkRemoveDocuments(int document_count = 10'000'000);
+void BenchmarkDocumentChurn(int document_count = 400'000);
+void BenchmarkTermDictionary();
+void BenchmarkQueryProfile();
+void BenchmarkSharedVocabulary();
+void BenchmarkLongQueries();
+void BenchmarkStandingQueries();
+void BenchmarkReadReplicas();
+
+void RunBenchmarks();
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <map>
+#include <memory_resource>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -15,10 +18,54 @@ template <typename Key, typename Value>
 class ConcurrentMap
 {
 private:
+    // Передаёт выделения внешнему ресурсу под общим мьютексом: ресурс арены потока
+    // не потокобезопасен, а корзины пополняют свои буферы из разных потоков
+    class SynchronizedResource : public std::pmr::memory_resource
+    {
+    public:
+        explicit SynchronizedResource(std::pmr::memory_resource* upstream)
+            : upstream_(upstream)
+        {
+        }
+
+    private:
+        std::mutex mutex_;
+        std::pmr::memory_resource* upstream_;
+
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            std::lock_guard g(mutex_);
+            return upstream_->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override
+        {
+            std::lock_guard g(mutex_);
+            upstream_->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    // Узлы каждой корзины выделяются из её собственного монотонного буфера под мьютексом корзины,
+    // а буфер пополняется из общего ресурса карты
     struct Bucket
     {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        explicit Bucket(const allocator_type& allocator)
+            : resource(allocator.resource())
+        {
+        }
+
         std::mutex mutex;
-        std::map<Key, Value> map;
+        std::pmr::monotonic_buffer_resource resource;
+        std::pmr::map<Key, Value> map{ &resource };
+        // меняется только под mutex
+        uint64_t lock_acquisitions = 0;
     };
 
 public:
@@ -32,11 +79,13 @@ public:
         Access(const Key& key, Bucket& bucket)
             : guard(bucket.mutex), ref_to_value(bucket.map[key])
         {
+            ++bucket.lock_acquisitions;
         }
     };
 
-    explicit ConcurrentMap(size_t bucket_count)
-        : buckets_(bucket_count)
+    // Корзины и их буферы выделяются из upstream, например из арены запроса
+    explicit ConcurrentMap(size_t bucket_count, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : upstream_(upstream), buckets_(bucket_count, &upstream_)
     {
     }
 
@@ -46,17 +95,30 @@ public:
         return { key, bucket };
     }
 
-    std::map<Key, Value> BuildOrdinaryMap()
+    std::pmr::map<Key, Value> BuildOrdinaryMap(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
     {
-        std::map<Key, Value> result;
-        for (auto& [mutex, map] : buckets_)
+        std::pmr::map<Key, Value> result(resource);
+        for (auto& bucket : buckets_)
         {
-            std::lock_guard g(mutex);
-            result.insert(map.begin(), map.end());
+            std::lock_guard g(bucket.mutex);
+            ++bucket.lock_acquisitions;
+            result.insert(bucket.map.begin(), bucket.map.end());
         }
         return result;
     }
 
+    // Сколько раз захватывались мьютексы корзин; вызывается, когда доступов из других потоков нет
+    uint64_t GetLockAcquisitions() const
+    {
+        uint64_t lock_acquisitions = 0;
+        for (const auto& bucket : buckets_)
+        {
+            lock_acquisitions += bucket.lock_acquisitions;
+        }
+        return lock_acquisitions;
+    }
+
 private:
-    std::vector<Bucket> buckets_;
+    SynchronizedResource upstream_;
+    std::pmr::vector<Bucket> buckets_;
 };
@@ -0,0 +1,211 @@
+#include "corpus_loader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "string_processing.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+struct ParsedDocument {
+    int id = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+    std::vector<std::string_view> words;
+};
+
+struct ParsedChunk {
+    size_t index = 0;
+    std::vector<ParsedDocument> documents;
+};
+
+std::vector<std::string_view> SplitIntoChunks(std::string_view data, size_t chunk_size) {
+    std::vector<std::string_view> chunks;
+    chunk_size = std::max<size_t>(chunk_size, 1);
+    while (!data.empty()) {
+        size_t end = std::min(chunk_size, data.size());
+        if (end < data.size()) {
+            const size_t line_end = data.find('\n', end - 1);
+            end = line_end == std::string_view::npos ? data.size() : line_end + 1;
+        }
+        chunks.push_back(data.substr(0, end));
+        data.remove_prefix(end);
+    }
+    return chunks;
+}
+
+std::string_view NextField(std::string_view& line) {
+    const size_t tab = line.find('\t');
+    if (tab == std::string_view::npos) {
+        throw std::invalid_argument("Corpus line has too few fields"s);
+    }
+    const std::string_view field = line.substr(0, tab);
+    line.remove_prefix(tab + 1);
+    return field;
+}
+
+int ParseInt(std::string_view text) {
+    int value = 0;
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size()) {
+        throw std::invalid_argument("Invalid number "s + std::string(text) + " in corpus"s);
+    }
+    return value;
+}
+
+ParsedDocument ParseLine(std::string_view line) {
+    ParsedDocument document;
+    document.id = ParseInt(NextField(line));
+
+    const int status = ParseInt(NextField(line));
+    if (status < 0 || status > static_cast<int>(DocumentStatus::REMOVED)) {
+        throw std::invalid_argument("Invalid document status in corpus"s);
+    }
+    document.status = static_cast<DocumentStatus>(status);
+
+    for (const std::string_view rating : SplitIntoWords(NextField(line))) {
+        if (!rating.empty()) {
+            document.ratings.push_back(ParseInt(rating));
+        }
+    }
+
+    // тот же разбор, что и в AddDocument, чтобы длина документа не зависела от способа загрузки
+    document.words = SplitIntoWords(line);
+    return document;
+}
+
+std::vector<ParsedDocument> ParseChunk(std::string_view chunk) {
+    std::vector<ParsedDocument> documents;
+    while (!chunk.empty()) {
+        const size_t line_end = std::min(chunk.find('\n'), chunk.size());
+        std::string_view line = chunk.substr(0, line_end);
+        chunk.remove_prefix(std::min(line_end + 1, chunk.size()));
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (!line.empty()) {
+            documents.push_back(ParseLine(line));
+        }
+    }
+    return documents;
+}
+
+}
+
+CorpusLoadStats LoadCorpus(SearchServer& search_server, const std::string& path, const CorpusLoadOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+
+    const auto file = std::make_shared<const MappedFile>(path);
+    const std::vector<std::string_view> chunks = SplitIntoChunks(file->GetData(), options.chunk_size);
+    const std::shared_ptr<const void> word_storage = options.use_mapped_storage ? file : nullptr;
+
+    size_t tokenizer_count = options.tokenizer_count;
+    if (tokenizer_count == 0) {
+        tokenizer_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    tokenizer_count = std::max<size_t>(std::min(tokenizer_count, chunks.size()), 1);
+
+    BoundedQueue<ParsedChunk> queue(options.queue_capacity);
+    std::atomic<size_t> next_chunk{ 0 };
+
+    // Разобранные куски ждут индексации не дальше окна от первого непроиндексированного,
+    // иначе при одном медленном куске все следующие копились бы в памяти мимо очереди.
+    // Кусок indexed_count всегда внутри окна, поэтому его разбор не ждёт
+    const size_t reorder_window = options.queue_capacity + tokenizer_count;
+    std::mutex order_mutex;
+    std::condition_variable order_changed;
+    size_t indexed_count = 0;
+    bool is_stopping = false;
+    const auto wait_for_window = [&](size_t index) {
+        std::unique_lock lock(order_mutex);
+        order_changed.wait(lock, [&] { return is_stopping || index < indexed_count + reorder_window; });
+        return !is_stopping;
+    };
+    std::mutex error_mutex;
+    std::exception_ptr tokenizer_error;
+
+    std::vector<std::thread> tokenizers;
+    tokenizers.reserve(tokenizer_count);
+    for (size_t i = 0; i < tokenizer_count; ++i) {
+        tokenizers.emplace_back([&] {
+            try {
+                for (size_t index = next_chunk++; index < chunks.size(); index = next_chunk++) {
+                    if (!wait_for_window(index) || !queue.Push({ index, ParseChunk(chunks[index]) })) {
+                        return;
+                    }
+                }
+            } catch (...) {
+                std::lock_guard lock(error_mutex);
+                if (!tokenizer_error) {
+                    tokenizer_error = std::current_exception();
+                }
+                queue.Close();
+            }
+        });
+    }
+
+    const auto join_tokenizers = [&] {
+        {
+            std::lock_guard lock(order_mutex);
+            is_stopping = true;
+        }
+        order_changed.notify_all();
+        queue.Close();
+        for (std::thread& tokenizer : tokenizers) {
+            tokenizer.join();
+        }
+    };
+
+    CorpusLoadStats stats;
+    try {
+        // куски приходят в произвольном порядке, а индексируются по порядку,
+        // чтобы результат не зависел от планирования потоков
+        std::map<size_t, std::vector<ParsedDocument>> pending;
+        for (size_t expected = 0; expected < chunks.size();) {
+            std::optional<ParsedChunk> chunk = queue.Pop();
+            if (!chunk) {
+                break;
+            }
+            pending.emplace(chunk->index, std::move(chunk->documents));
+            for (auto it = pending.find(expected); it != pending.end(); it = pending.find(expected)) {
+                for (const ParsedDocument& document : it->second) {
+                    search_server.AddTokenizedDocument(document.id, document.words, document.status, document.ratings, word_storage);
+                    ++stats.document_count;
+                }
+                pending.erase(it);
+                ++expected;
+                {
+                    std::lock_guard lock(order_mutex);
+                    indexed_count = expected;
+                }
+                order_changed.notify_all();
+            }
+        }
+    } catch (...) {
+        join_tokenizers();
+        throw;
+    }
+    join_tokenizers();
+
+    if (tokenizer_error) {
+        std::rethrow_exception(tokenizer_error);
+    }
+
+    stats.bytes = file->GetData().size();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "mapped_file.h"
+#include "search_server.h"
+
+struct CorpusLoadOptions {
+    size_t chunk_size = 1 << 18;
+    size_t queue_capacity = 4;
+    // 0 — по числу аппаратных потоков
+    size_t tokenizer_count = 0;
+    // Слова сервера ссылаются прямо на отображение файла вместо копий. Файл нельзя
+    // изменять или усекать, пока жив сервер.
+    bool use_mapped_storage = false;
+};
+
+struct CorpusLoadStats {
+    size_t document_count = 0;
+    size_t bytes = 0;
+    double seconds = 0;
+};
+
+// Загружает корпус, по документу на строку: id<TAB>статус<TAB>рейтинги через пробел<TAB>текст,
+// статус — число 0..3 в порядке DocumentStatus. Файл режется на куски по границам строк,
+// куски разбираются параллельно и через ограниченную очередь передаются индексации
+// в вызывающем потоке в исходном порядке. Вперёд первого непроиндексированного куска
+// разбирается не больше queue_capacity + tokenizer_count кусков.
+CorpusLoadStats LoadCorpus(SearchServer& search_server, const std::string& path, const CorpusLoadOptions& options = {});
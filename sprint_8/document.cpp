@@ -2,18 +2,26 @@
 
 using namespace std::string_literals;
 
-Document::Document() = default;
+template <typename DocumentId, typename Relevance>
+BasicDocument<DocumentId, Relevance>::BasicDocument() = default;
 
-Document::Document(int id, double relevance, int rating)
+template <typename DocumentId, typename Relevance>
+BasicDocument<DocumentId, Relevance>::BasicDocument(DocumentId id, Relevance relevance, int rating)
     : id(id)
     , relevance(relevance)
     , rating(rating) {
 }
 
-std::ostream& operator<<(std::ostream & out, const Document & document) {
+template <typename DocumentId, typename Relevance>
+std::ostream& operator<<(std::ostream & out, const BasicDocument<DocumentId, Relevance> & document) {
     out << "{ "s
         << "document_id = "s << document.id << ", "s
         << "relevance = "s << document.relevance << ", "s
         << "rating = "s << document.rating << " }"s;
     return out;
-}
\ No newline at end of file
+}
+
+template struct BasicDocument<int, double>;
+template struct BasicDocument<uint32_t, float>;
+template std::ostream& operator<<(std::ostream& out, const BasicDocument<int, double>& document);
+template std::ostream& operator<<(std::ostream& out, const BasicDocument<uint32_t, float>& document);
\ No newline at end of file
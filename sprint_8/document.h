@@ -1,20 +1,26 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <string>
 
-struct Document {
+// Определён для (int, double) и (uint32_t, float)
+template <typename DocumentId, typename Relevance>
+struct BasicDocument {
 
-    Document();
+    BasicDocument();
 
-    Document(int id, double relevance, int rating);
+    BasicDocument(DocumentId id, Relevance relevance, int rating);
 
-    int id = 0;
-    double relevance = 0.0;
+    DocumentId id = 0;
+    Relevance relevance = 0;
     int rating = 0;
 };
 
-std::ostream& operator<<(std::ostream& out, const Document& document);
+using Document = BasicDocument<int, double>;
+
+template <typename DocumentId, typename Relevance>
+std::ostream& operator<<(std::ostream& out, const BasicDocument<DocumentId, Relevance>& document);
 
 enum class DocumentStatus {
     ACTUAL,
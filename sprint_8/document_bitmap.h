@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+class DocumentBitmap
+{
+public:
+    explicit DocumentBitmap(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : words_(resource)
+    {
+    }
+
+    void Set(size_t index)
+    {
+        if (index / BITS_PER_WORD >= words_.size())
+        {
+            words_.resize(index / BITS_PER_WORD + 1, 0);
+        }
+        words_[index / BITS_PER_WORD] |= Mask(index);
+    }
+
+    void Reset(size_t index)
+    {
+        if (index / BITS_PER_WORD < words_.size())
+        {
+            words_[index / BITS_PER_WORD] &= ~Mask(index);
+        }
+    }
+
+    bool Test(size_t index) const
+    {
+        return index / BITS_PER_WORD < words_.size() && (words_[index / BITS_PER_WORD] & Mask(index)) != 0;
+    }
+
+    void Clear()
+    {
+        words_.clear();
+    }
+
+private:
+    static const size_t BITS_PER_WORD = 64;
+
+    static uint64_t Mask(size_t index)
+    {
+        return uint64_t{ 1 } << (index % BITS_PER_WORD);
+    }
+
+    std::pmr::vector<uint64_t> words_;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <limits>
+#include <optional>
+
+#include "document.h"
+
+struct DocumentFilter {
+    std::optional<DocumentStatus> status;
+    int min_rating = std::numeric_limits<int>::min();
+    int max_rating = std::numeric_limits<int>::max();
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "document.h"
+
+// Отображает внешние id документов в плотные порядковые номера и хранит данные документов
+// отдельными массивами, индексированными номером. Номера удалённых документов по умолчанию
+// выдаются заново, только когда кончаются новые: документ со старым номером встаёт в середину
+// списков своих слов, а не в конец. С SetFreeOrdinalReuse(true) они переиспользуются сразу,
+// и массивы не растут от потока добавлений и удалений.
+template <typename DocumentId>
+class DocumentTable
+{
+public:
+    using Ordinal = uint32_t;
+
+    // Обходит внешние id по возрастанию
+    class IdIterator
+    {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = DocumentId;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const DocumentId*;
+        using reference = const DocumentId&;
+
+        IdIterator() = default;
+        explicit IdIterator(typename std::map<DocumentId, Ordinal>::const_iterator it)
+            : it_(it)
+        {
+        }
+
+        reference operator*() const { return it_->first; }
+        pointer operator->() const { return &it_->first; }
+        IdIterator& operator++()
+        {
+            ++it_;
+            return *this;
+        }
+        IdIterator operator++(int)
+        {
+            IdIterator previous = *this;
+            ++it_;
+            return previous;
+        }
+        IdIterator& operator--()
+        {
+            --it_;
+            return *this;
+        }
+        IdIterator operator--(int)
+        {
+            IdIterator previous = *this;
+            --it_;
+            return previous;
+        }
+        bool operator==(const IdIterator& other) const { return it_ == other.it_; }
+        bool operator!=(const IdIterator& other) const { return it_ != other.it_; }
+
+    private:
+        typename std::map<DocumentId, Ordinal>::const_iterator it_;
+    };
+
+    void SetFreeOrdinalReuse(bool reuse)
+    {
+        reuse_free_ordinals_ = reuse;
+    }
+
+    // Документа с document_id ещё не должно быть в таблице
+    Ordinal Add(DocumentId document_id, int rating, DocumentStatus status)
+    {
+        Ordinal ordinal;
+        if (free_ordinals_.empty() || (!reuse_free_ordinals_ && ids_.size() < std::numeric_limits<Ordinal>::max()))
+        {
+            ordinal = static_cast<Ordinal>(ids_.size());
+            ids_.push_back(document_id);
+            ratings_.push_back(rating);
+            statuses_.push_back(status);
+            is_alive_.push_back(true);
+        }
+        else
+        {
+            ordinal = free_ordinals_.back();
+            free_ordinals_.pop_back();
+            ids_[ordinal] = document_id;
+            ratings_[ordinal] = rating;
+            statuses_[ordinal] = status;
+            is_alive_[ordinal] = true;
+        }
+        id_to_ordinal_.emplace(document_id, ordinal);
+        return ordinal;
+    }
+
+    void Remove(Ordinal ordinal)
+    {
+        id_to_ordinal_.erase(ids_[ordinal]);
+        is_alive_[ordinal] = false;
+        free_ordinals_.push_back(ordinal);
+    }
+
+    // nullptr, если документа нет
+    const Ordinal* Find(DocumentId document_id) const
+    {
+        const auto it = id_to_ordinal_.find(document_id);
+        return it == id_to_ordinal_.end() ? nullptr : &it->second;
+    }
+    // Бросает std::out_of_range, если документа нет
+    Ordinal At(DocumentId document_id) const
+    {
+        return id_to_ordinal_.at(document_id);
+    }
+
+    DocumentId GetId(Ordinal ordinal) const { return ids_[ordinal]; }
+    int GetRating(Ordinal ordinal) const { return ratings_[ordinal]; }
+    DocumentStatus GetStatus(Ordinal ordinal) const { return statuses_[ordinal]; }
+    bool IsAlive(Ordinal ordinal) const { return is_alive_[ordinal]; }
+
+    size_t size() const { return id_to_ordinal_.size(); }
+    // Число выданных номеров вместе со свободными; все номера меньше него
+    size_t GetCapacity() const { return ids_.size(); }
+
+    IdIterator begin() const { return IdIterator(id_to_ordinal_.begin()); }
+    IdIterator end() const { return IdIterator(id_to_ordinal_.end()); }
+
+private:
+    std::map<DocumentId, Ordinal> id_to_ordinal_;
+    std::vector<DocumentId> ids_;
+    std::vector<int> ratings_;
+    std::vector<DocumentStatus> statuses_;
+    std::vector<char> is_alive_;
+    std::vector<Ordinal> free_ordinals_;
+    bool reuse_free_ordinals_ = false;
+};
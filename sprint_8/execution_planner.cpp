@@ -0,0 +1,157 @@
+#include "execution_planner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <execution>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "concurrent_map.h"
+#include "query_arena.h"
+#include "score_kernels.h"
+
+namespace {
+
+const size_t MIN_PARALLEL_THRESHOLD = 1'000;
+const size_t MAX_PARALLEL_THRESHOLD = 10'000'000;
+// столько же корзин у аккумулятора параллельного пути
+const size_t CALIBRATION_BUCKET_COUNT = 100;
+
+size_t GetHardwareConcurrency() {
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+template <typename Function>
+double MeasureBestSeconds(Function function, int repeat_count) {
+    double best = 0.0;
+    for (int i = 0; i < repeat_count; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = i == 0 ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+// Последовательный путь складывает вхождения ядром плотного аккумулятора, параллельный —
+// в ConcurrentMap с мьютексом на корзину; обе стоимости измеряются на этих же структурах
+ExecutionCosts MeasureExecutionCosts() {
+    const size_t thread_count = GetHardwareConcurrency();
+    if (thread_count == 1) {
+        return {};
+    }
+
+    const uint32_t posting_count = 1 << 16;
+    std::vector<uint32_t> document_ids(posting_count);
+    std::iota(document_ids.begin(), document_ids.end(), 0);
+    const std::vector<double> frequencies(posting_count, 0.5);
+
+    ExecutionCosts costs;
+    const ScoreKernels<double>& kernels = GetScoreKernels<double>();
+    std::vector<double> accumulator(posting_count);
+    costs.sequential_seconds_per_posting = MeasureBestSeconds([&] {
+        std::fill(accumulator.begin(), accumulator.end(), 0.0);
+        kernels.accumulate(document_ids.data(), frequencies.data(), posting_count, 1.5, accumulator.data());
+    }, 5) / posting_count;
+
+    costs.parallel_seconds_per_posting = MeasureBestSeconds([&] {
+        const QueryArenaScope arena;
+        ConcurrentMap<uint32_t, double> document_to_relevance(CALIBRATION_BUCKET_COUNT, arena.Resource());
+        for (const uint32_t document_id : document_ids) {
+            document_to_relevance[document_id].ref_to_value += 0.5 * 1.5;
+        }
+        document_to_relevance.BuildOrdinaryMap(arena.Resource());
+    }, 3) / posting_count;
+
+    std::vector<int> tiny(thread_count);
+    std::atomic<int> sink{ 0 };
+    costs.task_seconds = MeasureBestSeconds([&tiny, &sink] {
+        std::for_each(std::execution::par, tiny.begin(), tiny.end(), [&sink](int value) {
+            sink += value;
+        });
+    }, 5) / thread_count;
+    return costs;
+}
+
+// Наименьшее число вхождений, при котором все потоки обходят их быстрее последовательного пути
+size_t ComputeParallelThreshold(const ExecutionCosts& costs, size_t thread_count) {
+    const double parallel_seconds_per_posting = costs.parallel_seconds_per_posting / thread_count;
+    if (thread_count == 1 || costs.sequential_seconds_per_posting <= parallel_seconds_per_posting) {
+        return MAX_PARALLEL_THRESHOLD;
+    }
+    const double threshold = costs.task_seconds * thread_count / (costs.sequential_seconds_per_posting - parallel_seconds_per_posting);
+    return std::clamp(static_cast<size_t>(threshold), MIN_PARALLEL_THRESHOLD, MAX_PARALLEL_THRESHOLD);
+}
+
+}
+
+const ExecutionCosts& ExecutionPlanner::CalibrateCosts() {
+    static const ExecutionCosts costs = MeasureExecutionCosts();
+    return costs;
+}
+
+size_t ExecutionPlanner::CalibrateParallelThreshold() {
+    static const size_t threshold = ComputeParallelThreshold(CalibrateCosts(), GetHardwareConcurrency());
+    return threshold;
+}
+
+ExecutionPlanner::ExecutionPlanner()
+    : ExecutionPlanner(CalibrateParallelThreshold(), CalibrateCosts()) {
+}
+
+ExecutionPlanner::ExecutionPlanner(size_t parallel_threshold)
+    : ExecutionPlanner(parallel_threshold, ExecutionCosts{}) {
+}
+
+ExecutionPlanner::ExecutionPlanner(size_t parallel_threshold, const ExecutionCosts& costs)
+    : parallel_threshold_(std::max<size_t>(parallel_threshold, 1))
+    , costs_(costs)
+    , max_parallelism_(GetHardwareConcurrency()) {
+}
+
+ExecutionDecision ExecutionPlanner::Choose(size_t estimated_postings) const {
+    ExecutionDecision decision;
+    decision.estimated_postings = estimated_postings;
+
+    if (max_parallelism_ > 1 && estimated_postings >= parallel_threshold_.load(std::memory_order_relaxed)) {
+        decision.mode = ExecutionMode::PARALLEL;
+        decision.parallelism = ChooseParallelism(estimated_postings);
+        ++parallel_queries_;
+        parallel_postings_ += estimated_postings;
+        parallel_tasks_ += decision.parallelism;
+    }
+    else {
+        ++sequential_queries_;
+        sequential_postings_ += estimated_postings;
+    }
+    return decision;
+}
+
+// Время d задач — d * task_seconds + postings * parallel_seconds_per_posting / d,
+// наименьшее при d = sqrt(postings * parallel_seconds_per_posting / task_seconds)
+size_t ExecutionPlanner::ChooseParallelism(size_t estimated_postings) const {
+    if (costs_.task_seconds <= 0.0 || costs_.parallel_seconds_per_posting <= 0.0) {
+        return max_parallelism_;
+    }
+    const double parallelism = std::sqrt(estimated_postings * costs_.parallel_seconds_per_posting / costs_.task_seconds);
+    return std::clamp<size_t>(static_cast<size_t>(std::lround(parallelism)), 2, max_parallelism_);
+}
+
+void ExecutionPlanner::SetParallelThreshold(size_t parallel_threshold) {
+    parallel_threshold_.store(std::max<size_t>(parallel_threshold, 1), std::memory_order_relaxed);
+}
+
+size_t ExecutionPlanner::GetParallelThreshold() const {
+    return parallel_threshold_.load(std::memory_order_relaxed);
+}
+
+size_t ExecutionPlanner::GetMaxParallelism() const {
+    return max_parallelism_;
+}
+
+ExecutionStats ExecutionPlanner::GetStats() const {
+    return { sequential_queries_.load(), parallel_queries_.load(), sequential_postings_.load(), parallel_postings_.load(), parallel_tasks_.load() };
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class ExecutionMode {
+    SEQUENTIAL,
+    PARALLEL,
+};
+
+struct ExecutionDecision {
+    ExecutionMode mode = ExecutionMode::SEQUENTIAL;
+    size_t estimated_postings = 0;
+    // число параллельных задач, на которые делится обход; 1 при последовательном выполнении
+    size_t parallelism = 1;
+};
+
+struct ExecutionStats {
+    uint64_t sequential_queries = 0;
+    uint64_t parallel_queries = 0;
+    uint64_t sequential_postings = 0;
+    uint64_t parallel_postings = 0;
+    // сумма parallelism параллельных запросов
+    uint64_t parallel_tasks = 0;
+};
+
+// Стоимости путей выполнения, измеренные на этом компьютере; нули — не измерены
+struct ExecutionCosts {
+    // плотный аккумулятор последовательного пути
+    double sequential_seconds_per_posting = 0.0;
+    // аккумулятор параллельного пути с блокировками корзин, в одном потоке
+    double parallel_seconds_per_posting = 0.0;
+    // запуск одной параллельной задачи
+    double task_seconds = 0.0;
+};
+
+// Выбирает последовательное или параллельное выполнение запроса и число параллельных
+// задач по оценке объёма работы — суммарной длине списков документов слов запроса.
+// Стоимости по умолчанию измеряются один раз при первом создании планировщика на тех же
+// аккумуляторах, что и пути поиска; если параллельный путь не обгоняет последовательный
+// даже на всех потоках, порог равен максимальному и запросы выполняются последовательно.
+class ExecutionPlanner {
+public:
+    ExecutionPlanner();
+    explicit ExecutionPlanner(size_t parallel_threshold);
+
+    ExecutionDecision Choose(size_t estimated_postings) const;
+
+    // Можно вызывать одновременно с Choose
+    void SetParallelThreshold(size_t parallel_threshold);
+    size_t GetParallelThreshold() const;
+    size_t GetMaxParallelism() const;
+
+    ExecutionStats GetStats() const;
+
+    static const ExecutionCosts& CalibrateCosts();
+    static size_t CalibrateParallelThreshold();
+
+private:
+    std::atomic<size_t> parallel_threshold_;
+    const ExecutionCosts costs_;
+    const size_t max_parallelism_;
+
+    mutable std::atomic<uint64_t> sequential_queries_{ 0 };
+    mutable std::atomic<uint64_t> parallel_queries_{ 0 };
+    mutable std::atomic<uint64_t> sequential_postings_{ 0 };
+    mutable std::atomic<uint64_t> parallel_postings_{ 0 };
+    mutable std::atomic<uint64_t> parallel_tasks_{ 0 };
+
+    ExecutionPlanner(size_t parallel_threshold, const ExecutionCosts& costs);
+    // Число задач, при котором запуск задач и их доля обхода в сумме дешевле всего
+    size_t ChooseParallelism(size_t estimated_postings) const;
+};
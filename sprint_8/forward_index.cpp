@@ -0,0 +1,57 @@
+#include "forward_index.h"
+
+template <typename Frequency>
+void ForwardIndex<Frequency>::Add(size_t document_id, const std::vector<TermFrequency<Frequency>>& entries)
+{
+    if (document_id >= extents_.size())
+    {
+        extents_.resize(document_id + 1);
+    }
+    extents_[document_id] = { entries_.size(), static_cast<uint32_t>(entries.size()) };
+    entries_.insert(entries_.end(), entries.begin(), entries.end());
+}
+
+template <typename Frequency>
+void ForwardIndex<Frequency>::Remove(size_t document_id)
+{
+    if (document_id >= extents_.size())
+    {
+        return;
+    }
+    garbage_ += extents_[document_id].length;
+    extents_[document_id] = {};
+    if (garbage_ * 2 > entries_.size())
+    {
+        Compact();
+    }
+}
+
+template <typename Frequency>
+TermFrequencies<Frequency> ForwardIndex<Frequency>::Get(size_t document_id) const
+{
+    if (document_id >= extents_.size())
+    {
+        return {};
+    }
+    const Extent& extent = extents_[document_id];
+    const TermFrequency<Frequency>* first = entries_.data() + extent.offset;
+    return { first, first + extent.length };
+}
+
+template <typename Frequency>
+void ForwardIndex<Frequency>::Compact()
+{
+    std::vector<TermFrequency<Frequency>> entries;
+    entries.reserve(entries_.size() - garbage_);
+    for (Extent& extent : extents_)
+    {
+        const size_t offset = entries.size();
+        entries.insert(entries.end(), entries_.begin() + extent.offset, entries_.begin() + extent.offset + extent.length);
+        extent.offset = extent.length == 0 ? 0 : offset;
+    }
+    entries_ = std::move(entries);
+    garbage_ = 0;
+}
+
+template class ForwardIndex<double>;
+template class ForwardIndex<float>;
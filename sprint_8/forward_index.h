@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+template <typename Frequency>
+struct TermFrequency
+{
+    int term_id = 0;
+    Frequency frequency = 0;
+};
+
+// Непрерывный участок прямого индекса. Действителен до следующего изменения индекса.
+template <typename Frequency>
+class TermFrequencies
+{
+public:
+    TermFrequencies() = default;
+    TermFrequencies(const TermFrequency<Frequency>* first, const TermFrequency<Frequency>* last)
+        : first_(first), last_(last)
+    {
+    }
+
+    const TermFrequency<Frequency>* begin() const { return first_; }
+    const TermFrequency<Frequency>* end() const { return last_; }
+    size_t size() const { return static_cast<size_t>(last_ - first_); }
+    bool empty() const { return first_ == last_; }
+
+private:
+    const TermFrequency<Frequency>* first_ = nullptr;
+    const TermFrequency<Frequency>* last_ = nullptr;
+};
+
+// Пары (слово, частота) документа в порядке id слов
+template <typename Frequency>
+class WordFrequencies
+{
+public:
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, Frequency>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(const TermFrequency<Frequency>* entry, const std::vector<std::string_view>* words)
+            : entry_(entry), words_(words)
+        {
+        }
+
+        value_type operator*() const { return { (*words_)[entry_->term_id], entry_->frequency }; }
+        Iterator& operator++()
+        {
+            ++entry_;
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return entry_ == other.entry_; }
+        bool operator!=(const Iterator& other) const { return entry_ != other.entry_; }
+
+    private:
+        const TermFrequency<Frequency>* entry_;
+        const std::vector<std::string_view>* words_;
+    };
+
+    WordFrequencies() = default;
+    WordFrequencies(TermFrequencies<Frequency> entries, const std::vector<std::string_view>* words)
+        : entries_(entries), words_(words)
+    {
+    }
+
+    Iterator begin() const { return { entries_.begin(), words_ }; }
+    Iterator end() const { return { entries_.end(), words_ }; }
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+
+private:
+    TermFrequencies<Frequency> entries_;
+    const std::vector<std::string_view>* words_ = nullptr;
+};
+
+// Прямой индекс: частоты слов всех документов в одном массиве, у каждого документа —
+// смещение и длина своего участка. Участки удалённых документов остаются дырами,
+// пока их суммарный размер не превысит половину массива; тогда массив уплотняется.
+// Определён для частот double и float.
+template <typename Frequency>
+class ForwardIndex
+{
+public:
+    // entries должны быть упорядочены по term_id без повторов
+    void Add(size_t document_id, const std::vector<TermFrequency<Frequency>>& entries);
+    void Remove(size_t document_id);
+
+    TermFrequencies<Frequency> Get(size_t document_id) const;
+
+private:
+    struct Extent
+    {
+        size_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    std::vector<TermFrequency<Frequency>> entries_;
+    std::vector<Extent> extents_;
+    size_t garbage_ = 0;
+
+    void Compact();
+};
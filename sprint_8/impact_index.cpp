@@ -0,0 +1,96 @@
+#include "impact_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "posting_list.h"
+
+template <typename DocumentFreqs>
+void ImpactIndex::Build(const std::vector<DocumentFreqs>& term_postings, int document_count)
+{
+    Clear();
+    term_segments_.resize(term_postings.size());
+
+    double max_impact = 0.0;
+    for (const DocumentFreqs& document_freqs : term_postings)
+    {
+        if (document_freqs.empty())
+        {
+            continue;
+        }
+        const double inverse_document_freq = std::log(document_count * 1.0 / document_freqs.size());
+        for (const auto [document_id, term_freq] : document_freqs)
+        {
+            max_impact = std::max(max_impact, term_freq * inverse_document_freq);
+        }
+    }
+    impact_step_ = max_impact > 0.0 ? max_impact / MAX_IMPACT : 1.0;
+
+    std::vector<std::pair<uint32_t, uint32_t>> impact_documents;
+    for (size_t term_id = 0; term_id < term_postings.size(); ++term_id)
+    {
+        const DocumentFreqs& document_freqs = term_postings[term_id];
+        if (document_freqs.empty())
+        {
+            continue;
+        }
+        const double inverse_document_freq = std::log(document_count * 1.0 / document_freqs.size());
+
+        impact_documents.clear();
+        for (const auto [document_id, term_freq] : document_freqs)
+        {
+            const double impact = std::ceil(term_freq * inverse_document_freq / impact_step_);
+            impact_documents.emplace_back(std::min(static_cast<uint32_t>(impact), MAX_IMPACT), document_id);
+        }
+        std::sort(impact_documents.begin(), impact_documents.end(), [](const auto& lhs, const auto& rhs)
+            { return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second); });
+
+        std::vector<Segment>& segments = term_segments_[term_id];
+        for (const auto& [impact, document_id] : impact_documents)
+        {
+            const uint32_t position = static_cast<uint32_t>(document_ids_.size());
+            if (segments.empty() || segments.back().impact != impact)
+            {
+                segments.push_back({ impact, position, position });
+            }
+            document_ids_.push_back(document_id);
+            ++segments.back().end;
+        }
+    }
+    is_built_ = true;
+}
+
+template void ImpactIndex::Build(const std::vector<PostingList<uint32_t, double>>&, int);
+template void ImpactIndex::Build(const std::vector<PostingList<uint32_t, float>>&, int);
+
+void ImpactIndex::Clear()
+{
+    is_built_ = false;
+    term_segments_.clear();
+    document_ids_.clear();
+}
+
+bool ImpactIndex::IsBuilt() const
+{
+    return is_built_;
+}
+
+const std::vector<ImpactIndex::Segment>* ImpactIndex::FindSegments(int term_id) const
+{
+    if (term_id < 0 || static_cast<size_t>(term_id) >= term_segments_.size() || term_segments_[term_id].empty())
+    {
+        return nullptr;
+    }
+    return &term_segments_[term_id];
+}
+
+const uint32_t* ImpactIndex::GetDocumentIds() const
+{
+    return document_ids_.data();
+}
+
+double ImpactIndex::GetImpactStep() const
+{
+    return impact_step_;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Списки документов термов, упорядоченные по убыванию вклада tf * idf. Вклады
+// квантуются в MAX_IMPACT уровней с округлением вверх, документы одного уровня
+// хранятся подряд одним сегментом.
+class ImpactIndex
+{
+public:
+    static constexpr uint32_t MAX_IMPACT = 255;
+
+    struct Segment
+    {
+        uint32_t impact;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    // term_postings индексируется id терма. Определён для списков PostingList<uint32_t, double>
+    // и PostingList<uint32_t, float>
+    template <typename DocumentFreqs>
+    void Build(const std::vector<DocumentFreqs>& term_postings, int document_count);
+    void Clear();
+
+    bool IsBuilt() const;
+
+    // Сегменты терма в порядке убывания вклада; nullptr, если терма нет в индексе
+    const std::vector<Segment>* FindSegments(int term_id) const;
+    const uint32_t* GetDocumentIds() const;
+
+    double GetImpactStep() const;
+
+private:
+    bool is_built_ = false;
+    double impact_step_ = 0.0;
+    std::vector<std::vector<Segment>> term_segments_;
+    std::vector<uint32_t> document_ids_;
+};
@@ -0,0 +1,243 @@
+#include "load_generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "process_queries.h"
+#include "request_queue.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Даёт потокам время запуститься до первого запланированного запроса
+constexpr std::chrono::milliseconds WARMUP_DELAY{ 10 };
+
+struct ThreadResult {
+    std::vector<Clock::duration> latencies;
+    std::vector<Clock::duration> service_times;
+    size_t window_requests = 0;
+    size_t no_result_requests = 0;
+    Clock::time_point last_completion{};
+};
+
+LatencySummary Summarize(std::vector<Clock::duration>& durations) {
+    LatencySummary summary;
+    summary.count = durations.size();
+    if (durations.empty()) {
+        return summary;
+    }
+    std::sort(durations.begin(), durations.end());
+    const auto percentile = [&durations](double fraction) {
+        const size_t rank = static_cast<size_t>(std::ceil(fraction * durations.size()));
+        return std::chrono::duration_cast<std::chrono::microseconds>(durations[std::clamp<size_t>(rank, 1, durations.size()) - 1]);
+    };
+    summary.p50 = percentile(0.5);
+    summary.p99 = percentile(0.99);
+    summary.p999 = percentile(0.999);
+    summary.max = std::chrono::duration_cast<std::chrono::microseconds>(durations.back());
+    return summary;
+}
+
+// Запускает count событий по расписанию start + interval * i на thread_count потоках;
+// событие, для которого не нашлось свободного потока, ждёт в очереди, и это ожидание
+// входит в его задержку
+template <typename Handler>
+std::vector<ThreadResult> RunOpenLoop(size_t thread_count, size_t count, Clock::time_point start, std::chrono::duration<double> interval,
+                                      Handler handler) {
+    std::vector<ThreadResult> results(thread_count);
+    std::atomic<size_t> next_index{ 0 };
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    std::vector<std::thread> threads;
+    for (size_t thread_index = 0; thread_index < thread_count; ++thread_index) {
+        threads.emplace_back([&, thread_index] {
+            ThreadResult& result = results[thread_index];
+            try {
+                for (size_t i = next_index++; i < count; i = next_index++) {
+                    const auto intended = start + std::chrono::duration_cast<Clock::duration>(interval * i);
+                    std::this_thread::sleep_until(intended);
+                    const auto started = Clock::now();
+                    handler(thread_index, i, result);
+                    const auto completed = Clock::now();
+                    result.latencies.push_back(completed - intended);
+                    result.service_times.push_back(completed - started);
+                    result.last_completion = completed;
+                }
+            } catch (...) {
+                std::lock_guard lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next_index = count;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return results;
+}
+
+}
+
+LoadTestReport RunLoadTest(SearchServer& search_server, const std::vector<std::string>& queries,
+                           const std::vector<std::string>& ingest_documents, const LoadTestOptions& options) {
+    if (queries.empty() || options.queries_per_second <= 0 || options.thread_count == 0) {
+        throw std::invalid_argument("Load test needs queries, a positive rate and at least one thread"s);
+    }
+    if (options.mutations_per_second > 0 && ingest_documents.empty()) {
+        throw std::invalid_argument("Load test mutations need documents to ingest"s);
+    }
+
+    const size_t batch_size = std::max<size_t>(options.batch_size, 1);
+    const double seconds = std::chrono::duration<double>(options.duration).count();
+    const size_t request_count = static_cast<size_t>(options.queries_per_second * seconds / batch_size);
+    const size_t mutation_count = static_cast<size_t>(options.mutations_per_second * seconds);
+    const auto start = Clock::now() + WARMUP_DELAY;
+
+    std::shared_mutex server_mutex;
+    const int first_ingest_document_id = search_server.begin() == search_server.end() ? 0 : *std::prev(search_server.end()) + 1;
+
+    std::vector<ThreadResult> mutation_results;
+    std::exception_ptr mutation_error;
+    std::thread mutator;
+    if (mutation_count > 0) {
+        mutator = std::thread([&] {
+            const std::chrono::duration<double> interval(1.0 / options.mutations_per_second);
+            try {
+                mutation_results = RunOpenLoop(1, mutation_count, start, interval, [&](size_t, size_t i, ThreadResult&) {
+                    const int document_id = first_ingest_document_id + static_cast<int>(i / 2);
+                    std::unique_lock lock(server_mutex);
+                    if (i % 2 == 0) {
+                        search_server.AddDocument(document_id, ingest_documents[i / 2 % ingest_documents.size()], DocumentStatus::ACTUAL, { 1 });
+                    } else {
+                        search_server.RemoveDocument(document_id);
+                    }
+                });
+            } catch (...) {
+                mutation_error = std::current_exception();
+            }
+        });
+    }
+
+    std::vector<RequestQueue> request_queues;
+    for (size_t i = 0; i < options.thread_count; ++i) {
+        request_queues.emplace_back(search_server);
+    }
+    const std::chrono::duration<double> interval(batch_size / options.queries_per_second);
+    std::vector<ThreadResult> query_results;
+    try {
+        query_results = RunOpenLoop(options.thread_count, request_count, start, interval,
+                                    [&](size_t thread_index, size_t i, ThreadResult& result) {
+            if (options.batch_size == 0) {
+                std::shared_lock lock(server_mutex);
+                request_queues[thread_index].AddFindRequest(queries[i % queries.size()]);
+                return;
+            }
+            std::vector<std::string> batch;
+            for (size_t j = 0; j < batch_size; ++j) {
+                batch.push_back(queries[(i * batch_size + j) % queries.size()]);
+            }
+            std::shared_lock lock(server_mutex);
+            for (const std::vector<Document>& documents : ProcessQueries(search_server, batch)) {
+                ++result.window_requests;
+                result.no_result_requests += documents.empty();
+            }
+        });
+    } catch (...) {
+        if (mutator.joinable()) {
+            mutator.join();
+        }
+        throw;
+    }
+    if (mutator.joinable()) {
+        mutator.join();
+    }
+    if (mutation_error) {
+        std::rethrow_exception(mutation_error);
+    }
+
+    LoadTestReport report;
+    std::vector<Clock::duration> latencies;
+    std::vector<Clock::duration> service_times;
+    Clock::time_point last_completion = start;
+    for (size_t thread_index = 0; thread_index < query_results.size(); ++thread_index) {
+        ThreadResult& result = query_results[thread_index];
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        service_times.insert(service_times.end(), result.service_times.begin(), result.service_times.end());
+        last_completion = std::max(last_completion, result.last_completion);
+        if (options.batch_size == 0) {
+            report.window_requests += request_queues[thread_index].GetRequestCount();
+            report.no_result_requests += request_queues[thread_index].GetNoResultRequests();
+        } else {
+            report.window_requests += result.window_requests;
+            report.no_result_requests += result.no_result_requests;
+        }
+    }
+    report.latency = Summarize(latencies);
+    report.service_time = Summarize(service_times);
+    if (!mutation_results.empty()) {
+        report.mutation_latency = Summarize(mutation_results.front().latencies);
+    }
+    const double elapsed = std::chrono::duration<double>(last_completion - start).count();
+    report.achieved_queries_per_second = elapsed > 0 ? request_count * batch_size / elapsed : 0;
+    return report;
+}
+
+std::vector<std::string> ReadQueryLog(const std::string& path) {
+    std::ifstream input(path);
+    if (!input) {
+        throw std::invalid_argument("Cannot open query log "s + path);
+    }
+    std::vector<std::string> queries;
+    for (std::string line; std::getline(input, line);) {
+        if (!line.empty()) {
+            queries.push_back(std::move(line));
+        }
+    }
+    return queries;
+}
+
+std::vector<std::string> GenerateZipfQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                             int query_count, int max_word_count, double exponent) {
+    std::vector<double> weights(dictionary.size());
+    for (size_t i = 0; i < weights.size(); ++i) {
+        weights[i] = 1.0 / std::pow(i + 1.0, exponent);
+    }
+    std::discrete_distribution<size_t> word_distribution(weights.begin(), weights.end());
+
+    std::vector<std::string> queries;
+    for (int i = 0; i < query_count; ++i) {
+        std::string query;
+        const int word_count = std::uniform_int_distribution(1, max_word_count)(generator);
+        for (int j = 0; j < word_count; ++j) {
+            if (!query.empty()) {
+                query.push_back(' ');
+            }
+            query += dictionary[word_distribution(generator)];
+        }
+        queries.push_back(std::move(query));
+    }
+    return queries;
+}
+
+std::ostream& operator<<(std::ostream& out, const LatencySummary& summary) {
+    return out << "p50 "s << summary.p50.count() << " us, p99 "s << summary.p99.count() << " us, p999 "s
+               << summary.p999.count() << " us, max "s << summary.max.count() << " us ("s << summary.count << ")"s;
+}
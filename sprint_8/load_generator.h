@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+struct LoadTestOptions {
+    // Частота отправки запросов; при batch_size > 0 считается в запросах, а не в пакетах
+    double queries_per_second = 1000;
+    std::chrono::milliseconds duration{ 5000 };
+    size_t thread_count = 4;
+    // 0 — каждый запрос отдельным FindTopDocuments через RequestQueue, иначе пакетами
+    // ProcessQueries такого размера
+    size_t batch_size = 0;
+    // Поток изменений: добавляется документ из ingest_documents с id больше всех
+    // существующих, следующим изменением удаляется, так что размер индекса не меняется.
+    // 0 — без изменений
+    double mutations_per_second = 0;
+};
+
+struct LatencySummary {
+    size_t count = 0;
+    std::chrono::microseconds p50{};
+    std::chrono::microseconds p99{};
+    std::chrono::microseconds p999{};
+    std::chrono::microseconds max{};
+};
+
+struct LoadTestReport {
+    // Задержка от запланированного момента отправки до ответа, включая ожидание в очереди
+    LatencySummary latency;
+    // Задержка от фактического начала выполнения: то, что показал бы замкнутый тест
+    LatencySummary service_time;
+    LatencySummary mutation_latency;
+    double achieved_queries_per_second = 0;
+    // Окна RequestQueue всех потоков (в пакетном режиме — все запросы)
+    size_t window_requests = 0;
+    size_t no_result_requests = 0;
+};
+
+// Открытый тест нагрузки: запросы отправляются по расписанию с постоянной частотой
+// независимо от того, успевает ли сервер, и выбираются из queries по кругу. Поток
+// изменений берёт исключительную блокировку, запросы — разделяемую.
+LoadTestReport RunLoadTest(SearchServer& search_server, const std::vector<std::string>& queries,
+                           const std::vector<std::string>& ingest_documents, const LoadTestOptions& options);
+
+// Журнал запросов: по запросу на строку, пустые строки пропускаются
+std::vector<std::string> ReadQueryLog(const std::string& path);
+
+// Слова запросов выбираются из dictionary по закону Ципфа: i-е по частоте — с весом 1 / (i + 1)^exponent
+std::vector<std::string> GenerateZipfQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                             int query_count, int max_word_count, double exponent = 1.0);
+
+std::ostream& operator<<(std::ostream& out, const LatencySummary& summary);
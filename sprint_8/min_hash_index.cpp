@@ -0,0 +1,204 @@
+#include "min_hash_index.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+uint64_t Mix(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+}
+
+MinHashIndex::Signature MinHashIndex::ComputeSignature(const std::vector<int>& term_ids)
+{
+    Signature signature;
+    signature.fill(std::numeric_limits<uint32_t>::max());
+    for (const int term_id : term_ids)
+    {
+        const uint64_t term_hash = Mix(static_cast<uint64_t>(term_id) + 1);
+        for (size_t i = 0; i < SIGNATURE_SIZE; ++i)
+        {
+            const uint32_t hash = static_cast<uint32_t>(Mix(term_hash + i * 0x9e3779b97f4a7c15ULL));
+            signature[i] = std::min(signature[i], hash);
+        }
+    }
+    return signature;
+}
+
+uint64_t MinHashIndex::HashBand(const Signature& signature, size_t band)
+{
+    uint64_t hash = band;
+    for (size_t row = 0; row < ROWS_PER_BAND; ++row)
+    {
+        hash = Mix(hash ^ signature[band * ROWS_PER_BAND + row]);
+    }
+    return hash;
+}
+
+void MinHashIndex::Add(uint32_t document_id, const std::vector<int>& term_ids)
+{
+    Entry& entry = entries_[document_id];
+    entry.signature = ComputeSignature(term_ids);
+    for (size_t band = 0; band < BAND_COUNT; ++band)
+    {
+        auto& document_ids = bands_[band][HashBand(entry.signature, band)];
+        entry.positions[band] = static_cast<uint32_t>(document_ids.size());
+        document_ids.push_back(document_id);
+    }
+}
+
+void MinHashIndex::Remove(uint32_t document_id)
+{
+    const auto it = entries_.find(document_id);
+    if (it == entries_.end())
+    {
+        return;
+    }
+    for (size_t band = 0; band < BAND_COUNT; ++band)
+    {
+        // на место документа встаёт последний документ корзины
+        const auto bucket = bands_[band].find(HashBand(it->second.signature, band));
+        auto& document_ids = bucket->second;
+        const uint32_t position = it->second.positions[band];
+        if (document_ids.back() != document_id)
+        {
+            document_ids[position] = document_ids.back();
+            entries_.at(document_ids[position]).positions[band] = position;
+        }
+        document_ids.pop_back();
+        if (document_ids.empty())
+        {
+            bands_[band].erase(bucket);
+        }
+    }
+    entries_.erase(it);
+}
+
+std::vector<uint32_t> MinHashIndex::FindCandidates(uint32_t document_id) const
+{
+    std::vector<uint32_t> candidates;
+    const auto it = entries_.find(document_id);
+    if (it == entries_.end())
+    {
+        return candidates;
+    }
+    for (size_t band = 0; band < BAND_COUNT; ++band)
+    {
+        const auto& document_ids = bands_[band].at(HashBand(it->second.signature, band));
+        std::copy_if(document_ids.begin(), document_ids.end(), std::back_inserter(candidates),
+            [document_id](uint32_t candidate) { return candidate != document_id; });
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    return candidates;
+}
+
+double MinHashIndex::EstimateSimilarity(uint32_t lhs_document_id, uint32_t rhs_document_id) const
+{
+    return EstimateSimilarity(entries_.at(lhs_document_id).signature, entries_.at(rhs_document_id).signature);
+}
+
+double MinHashIndex::EstimateSimilarity(const Signature& lhs, const Signature& rhs)
+{
+    size_t equal_count = 0;
+    for (size_t i = 0; i < SIGNATURE_SIZE; ++i)
+    {
+        equal_count += lhs[i] == rhs[i];
+    }
+    return equal_count * 1.0 / SIGNATURE_SIZE;
+}
+
+std::vector<std::vector<uint32_t>> MinHashIndex::GroupCandidates() const
+{
+    // система непересекающихся множеств над документами: корзина полосы объединяет всех своих
+    std::vector<uint32_t> document_ids;
+    std::unordered_map<uint32_t, uint32_t> document_indexes;
+    document_ids.reserve(entries_.size());
+    document_indexes.reserve(entries_.size());
+    for (const auto& [document_id, entry] : entries_)
+    {
+        document_indexes.emplace(document_id, static_cast<uint32_t>(document_ids.size()));
+        document_ids.push_back(document_id);
+    }
+    std::vector<uint32_t> parents(document_ids.size());
+    std::iota(parents.begin(), parents.end(), 0);
+    const auto find_root = [&parents](uint32_t index)
+    {
+        while (parents[index] != index)
+        {
+            parents[index] = parents[parents[index]];
+            index = parents[index];
+        }
+        return index;
+    };
+    for (const auto& buckets : bands_)
+    {
+        for (const auto& [hash, bucket_document_ids] : buckets)
+        {
+            const uint32_t first_root = find_root(document_indexes.at(bucket_document_ids.front()));
+            for (size_t i = 1; i < bucket_document_ids.size(); ++i)
+            {
+                const uint32_t root = find_root(document_indexes.at(bucket_document_ids[i]));
+                parents[root] = first_root;
+            }
+        }
+    }
+
+    std::unordered_map<uint32_t, size_t> group_indexes;
+    std::vector<std::vector<uint32_t>> groups;
+    for (uint32_t index = 0; index < document_ids.size(); ++index)
+    {
+        const auto [it, inserted] = group_indexes.emplace(find_root(index), groups.size());
+        if (inserted)
+        {
+            groups.emplace_back();
+        }
+        groups[it->second].push_back(document_ids[index]);
+    }
+    groups.erase(std::remove_if(groups.begin(), groups.end(), [](const std::vector<uint32_t>& group) { return group.size() < 2; }), groups.end());
+    return groups;
+}
+
+std::vector<uint32_t> MinHashIndex::SelectDuplicates(const std::vector<uint32_t>& group, double threshold) const
+{
+    // в корзинах лежат только оставленные документы, поэтому кластер одинаковых
+    // документов сравнивается с одним представителем, а не друг с другом
+    std::array<std::unordered_map<uint64_t, std::vector<const Signature*>>, BAND_COUNT> kept_bands;
+    std::vector<uint32_t> duplicates;
+    for (const uint32_t document_id : group)
+    {
+        const Signature& signature = entries_.at(document_id).signature;
+        std::array<uint64_t, BAND_COUNT> band_hashes;
+        bool is_duplicate = false;
+        for (size_t band = 0; band < BAND_COUNT && !is_duplicate; ++band)
+        {
+            band_hashes[band] = HashBand(signature, band);
+            const auto bucket = kept_bands[band].find(band_hashes[band]);
+            if (bucket != kept_bands[band].end())
+            {
+                is_duplicate = std::any_of(bucket->second.begin(), bucket->second.end(), [&signature, threshold](const Signature* kept)
+                    { return EstimateSimilarity(signature, *kept) >= threshold; });
+            }
+        }
+        if (is_duplicate)
+        {
+            duplicates.push_back(document_id);
+            continue;
+        }
+        for (size_t band = 0; band < BAND_COUNT; ++band)
+        {
+            kept_bands[band][band_hashes[band]].push_back(&signature);
+        }
+    }
+    return duplicates;
+}
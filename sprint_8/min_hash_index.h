@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// MinHash-сигнатуры множеств слов документов и LSH-индекс по полосам сигнатуры.
+// Документы, совпадающие хотя бы в одной полосе, считаются кандидатами в дубликаты;
+// доля совпавших позиций сигнатуры оценивает коэффициент Жаккара.
+class MinHashIndex
+{
+public:
+    static const size_t BAND_COUNT = 16;
+    static const size_t ROWS_PER_BAND = 4;
+    static const size_t SIGNATURE_SIZE = BAND_COUNT * ROWS_PER_BAND;
+
+    using Signature = std::array<uint32_t, SIGNATURE_SIZE>;
+
+    void Add(uint32_t document_id, const std::vector<int>& term_ids);
+    void Remove(uint32_t document_id);
+
+    std::vector<uint32_t> FindCandidates(uint32_t document_id) const;
+    double EstimateSimilarity(uint32_t lhs_document_id, uint32_t rhs_document_id) const;
+
+    // Разбивает документы на группы, связанные цепочками общих полос; документы разных
+    // групп никогда не бывают кандидатами друг для друга. Группы из одного документа не возвращаются
+    std::vector<std::vector<uint32_t>> GroupCandidates() const;
+    // Проходит документы группы по порядку и оставляет каждый, у которого среди уже
+    // оставленных нет похожего с оценкой не ниже threshold; возвращает остальные
+    std::vector<uint32_t> SelectDuplicates(const std::vector<uint32_t>& group, double threshold) const;
+
+private:
+    struct Entry
+    {
+        Signature signature;
+        // место документа в корзине каждой полосы
+        std::array<uint32_t, BAND_COUNT> positions;
+    };
+
+    std::unordered_map<uint32_t, Entry> entries_;
+    std::array<std::unordered_map<uint64_t, std::vector<uint32_t>>, BAND_COUNT> bands_;
+
+    static Signature ComputeSignature(const std::vector<int>& term_ids);
+    static double EstimateSimilarity(const Signature& lhs, const Signature& rhs);
+    static uint64_t HashBand(const Signature& signature, size_t band);
+};
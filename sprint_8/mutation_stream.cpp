@@ -0,0 +1,336 @@
+#include "mutation_stream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std::string_literals;
+
+namespace {
+
+const size_t FRAME_HEADER_SIZE = sizeof(uint64_t) + 2 * sizeof(uint32_t);
+const size_t RECEIVE_CHUNK_SIZE = 256 << 10;
+
+template <typename T>
+void WriteValue(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T ReadValue(const char* in) {
+    T value;
+    std::memcpy(&value, in, sizeof(value));
+    return value;
+}
+
+sockaddr_un MakeSocketAddress(const std::string& socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Invalid socket path "s + socket_path);
+    }
+    std::memcpy(address.sun_path, socket_path.data(), socket_path.size());
+    return address;
+}
+
+int WaitMilliseconds(std::chrono::milliseconds interval) {
+    return static_cast<int>(std::max<std::chrono::milliseconds::rep>(interval.count(), 1));
+}
+
+}
+
+MutationPublisher::MutationPublisher(const std::string& socket_path, const MutationPublisherOptions& options)
+    : socket_path_(socket_path)
+    , options_(options)
+{
+    const sockaddr_un address = MakeSocketAddress(socket_path_);
+    struct stat status;
+    if (lstat(socket_path_.c_str(), &status) == 0) {
+        if (!S_ISSOCK(status.st_mode)) {
+            throw std::invalid_argument("Not a socket: "s + socket_path_);
+        }
+        unlink(socket_path_.c_str());
+    }
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        throw std::invalid_argument("Cannot create socket: "s + std::strerror(errno));
+    }
+    if (bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listen_fd_, 16) != 0) {
+        const int error = errno;
+        close(listen_fd_);
+        throw std::invalid_argument("Cannot listen on "s + socket_path_ + ": "s + std::strerror(error));
+    }
+    sender_ = std::thread([this] { RunSender(); });
+}
+
+MutationPublisher::~MutationPublisher() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    sender_.join();
+    for (const Follower& follower : followers_) {
+        close(follower.fd);
+    }
+    close(listen_fd_);
+    unlink(socket_path_.c_str());
+}
+
+uint64_t MutationPublisher::PublishAdd(uint32_t document_id, const std::vector<std::string_view>& words, DocumentStatus status, const std::vector<int>& ratings) {
+    return Publish(EncodeWalAdd(document_id, words, status, ratings));
+}
+
+uint64_t MutationPublisher::PublishRemove(uint32_t document_id) {
+    return Publish(EncodeWalRemove(document_id));
+}
+
+uint64_t MutationPublisher::Publish(const std::string& payload) {
+    std::lock_guard lock(mutex_);
+    const uint64_t sequence = ++last_sequence_;
+    frame_offsets_.push_back(backlog_begin_ + backlog_.size());
+    WriteValue(backlog_, sequence);
+    WriteValue(backlog_, static_cast<uint32_t>(payload.size()));
+    WriteValue(backlog_, ComputeWalChecksum(payload));
+    backlog_ += payload;
+    ++stats_.records;
+    if (backlog_.size() > options_.backlog_bytes) {
+        TrimBacklog();
+    }
+    return sequence;
+}
+
+// Оставляет целые кадры примерно на половину backlog_bytes, чтобы не сдвигать буфер
+// после каждой публикации
+void MutationPublisher::TrimBacklog() {
+    const uint64_t keep_from = backlog_begin_ + backlog_.size() - options_.backlog_bytes / 2;
+    while (frame_offsets_.size() > 1 && frame_offsets_.front() < keep_from) {
+        frame_offsets_.pop_front();
+        ++first_sequence_;
+    }
+    backlog_.erase(0, frame_offsets_.front() - backlog_begin_);
+    backlog_begin_ = frame_offsets_.front();
+}
+
+uint64_t MutationPublisher::GetLastSequence() const {
+    std::lock_guard lock(mutex_);
+    return last_sequence_;
+}
+
+MutationPublisherStats MutationPublisher::GetStats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+void MutationPublisher::RunSender() {
+    std::vector<pollfd> poll_fds;
+    while (true) {
+        poll_fds.assign(1, { listen_fd_, POLLIN, 0 });
+        for (const Follower& follower : followers_) {
+            poll_fds.push_back({ follower.fd, POLLIN, 0 });
+        }
+        poll(poll_fds.data(), poll_fds.size(), WaitMilliseconds(options_.batch_interval));
+
+        std::lock_guard lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        // новые реплики в poll_fds не попали и проверяются на следующем круге
+        for (size_t i = 0; i + 1 < poll_fds.size(); ++i) {
+            if (poll_fds[i + 1].revents != 0 && !ReceiveFromFollower(followers_[i])) {
+                close(followers_[i].fd);
+                followers_[i].fd = -1;
+            }
+        }
+        for (Follower& follower : followers_) {
+            if (follower.fd >= 0 && !SendToFollower(follower)) {
+                close(follower.fd);
+                follower.fd = -1;
+            }
+        }
+        followers_.erase(std::remove_if(followers_.begin(), followers_.end(), [](const Follower& follower) { return follower.fd < 0; }),
+                         followers_.end());
+        if (poll_fds[0].revents != 0) {
+            AcceptFollowers();
+        }
+        stats_.followers = std::count_if(followers_.begin(), followers_.end(), [](const Follower& follower) {
+            return follower.offset != NO_OFFSET;
+        });
+    }
+}
+
+void MutationPublisher::AcceptFollowers() {
+    while (true) {
+        const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        followers_.push_back({ fd, NO_OFFSET });
+    }
+}
+
+bool MutationPublisher::ReceiveFromFollower(Follower& follower) {
+    if (follower.offset != NO_OFFSET) {
+        // после номера реплика ничего не присылает, поэтому готовность к чтению означает отключение
+        char byte;
+        return recv(follower.fd, &byte, 1, MSG_DONTWAIT) > 0;
+    }
+    uint64_t next_sequence = 0;
+    if (recv(follower.fd, &next_sequence, sizeof(next_sequence), MSG_DONTWAIT) != static_cast<ssize_t>(sizeof(next_sequence))) {
+        return false;
+    }
+    if (next_sequence < first_sequence_ || next_sequence > last_sequence_ + 1) {
+        return false;
+    }
+    follower.offset = next_sequence == last_sequence_ + 1 ? backlog_begin_ + backlog_.size() : frame_offsets_[next_sequence - first_sequence_];
+    return true;
+}
+
+bool MutationPublisher::SendToFollower(Follower& follower) {
+    if (follower.offset == NO_OFFSET) {
+        return true;
+    }
+    if (follower.offset < backlog_begin_) {
+        // реплика отстала больше, чем хранится кадров
+        return false;
+    }
+    const uint64_t backlog_end = backlog_begin_ + backlog_.size();
+    while (follower.offset < backlog_end) {
+        const size_t begin = static_cast<size_t>(follower.offset - backlog_begin_);
+        const ssize_t sent = send(follower.fd, backlog_.data() + begin, backlog_.size() - begin, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        follower.offset += static_cast<uint64_t>(sent);
+        stats_.bytes_sent += static_cast<uint64_t>(sent);
+    }
+    return true;
+}
+
+MutationSubscriber::MutationSubscriber(const std::string& socket_path, uint64_t next_sequence, BatchVisitor visitor,
+                                       const MutationSubscriberOptions& options)
+    : socket_path_(socket_path)
+    , options_(options)
+    , visitor_(std::move(visitor))
+    , next_sequence_(next_sequence)
+{
+    MakeSocketAddress(socket_path_);
+    receiver_ = std::thread([this] { RunReceiver(); });
+}
+
+MutationSubscriber::~MutationSubscriber() {
+    stopping_ = true;
+    receiver_.join();
+    Disconnect();
+}
+
+bool MutationSubscriber::IsConnected() const {
+    return is_connected_;
+}
+
+std::exception_ptr MutationSubscriber::GetError() const {
+    std::lock_guard lock(error_mutex_);
+    return error_;
+}
+
+bool MutationSubscriber::Connect() {
+    const sockaddr_un address = MakeSocketAddress(socket_path_);
+    fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        return false;
+    }
+    if (connect(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || send(fd_, &next_sequence_, sizeof(next_sequence_), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(next_sequence_))) {
+        Disconnect();
+        return false;
+    }
+    is_connected_ = true;
+    return true;
+}
+
+void MutationSubscriber::Disconnect() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    is_connected_ = false;
+}
+
+void MutationSubscriber::RunReceiver() {
+    std::string buffer(RECEIVE_CHUNK_SIZE, '\0');
+    size_t buffer_size = 0;
+    std::vector<MutationRecord> batch;
+    while (!stopping_) {
+        if (fd_ < 0) {
+            buffer_size = 0;
+            if (!Connect()) {
+                std::this_thread::sleep_for(options_.retry_interval);
+                continue;
+            }
+        }
+        pollfd poll_fd{ fd_, POLLIN, 0 };
+        if (poll(&poll_fd, 1, WaitMilliseconds(options_.retry_interval)) <= 0) {
+            continue;
+        }
+        if (buffer.size() - buffer_size < RECEIVE_CHUNK_SIZE) {
+            buffer.resize(buffer_size + RECEIVE_CHUNK_SIZE);
+        }
+        const ssize_t received = recv(fd_, buffer.data() + buffer_size, buffer.size() - buffer_size, 0);
+        if (received <= 0) {
+            if (received == 0 || errno != EINTR) {
+                Disconnect();
+            }
+            continue;
+        }
+        buffer_size += static_cast<size_t>(received);
+
+        batch.clear();
+        bool is_broken = false;
+        size_t offset = 0;
+        // next_sequence_ сдвигается, только когда visitor принял пачку
+        uint64_t next_sequence = next_sequence_;
+        while (buffer_size - offset >= FRAME_HEADER_SIZE) {
+            const char* header = buffer.data() + offset;
+            const auto sequence = ReadValue<uint64_t>(header);
+            const auto payload_size = ReadValue<uint32_t>(header + sizeof(uint64_t));
+            const auto checksum = ReadValue<uint32_t>(header + sizeof(uint64_t) + sizeof(uint32_t));
+            if (buffer_size - offset - FRAME_HEADER_SIZE < payload_size) {
+                break;
+            }
+            const std::string_view payload(header + FRAME_HEADER_SIZE, payload_size);
+            MutationRecord& mutation = batch.emplace_back();
+            mutation.sequence = sequence;
+            if (sequence != next_sequence || ComputeWalChecksum(payload) != checksum || !ParseWalRecord(payload, mutation.record)) {
+                batch.pop_back();
+                is_broken = true;
+                break;
+            }
+            ++next_sequence;
+            offset += FRAME_HEADER_SIZE + payload_size;
+        }
+        if (!batch.empty()) {
+            try {
+                visitor_(batch);
+            } catch (...) {
+                std::lock_guard lock(error_mutex_);
+                error_ = std::current_exception();
+                Disconnect();
+                return;
+            }
+            next_sequence_ = next_sequence;
+        }
+        if (is_broken) {
+            Disconnect();
+            continue;
+        }
+        std::memmove(buffer.data(), buffer.data() + offset, buffer_size - offset);
+        buffer_size -= offset;
+    }
+}
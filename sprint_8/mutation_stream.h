@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "document.h"
+#include "write_ahead_log.h"
+
+// Поток изменений от пишущего сервера к репликам через Unix-сокет. Каждый кадр —
+// номер изменения, длина, контрольная сумма и тело записи журнала. Реплика при
+// подключении присылает номер первого нужного ей изменения и получает всё, начиная
+// с него, пока оно ещё хранится у издателя.
+struct MutationPublisherOptions {
+    // сколько последних кадров хранится для отставших и переподключившихся реплик;
+    // реплика, которой нужны более старые, отключается
+    size_t backlog_bytes = 64 << 20;
+    // накопленные кадры отправляются репликам не реже этого интервала
+    std::chrono::milliseconds batch_interval{ 2 };
+};
+
+struct MutationPublisherStats {
+    uint64_t records = 0;
+    uint64_t bytes_sent = 0;
+    size_t followers = 0;
+};
+
+class MutationPublisher {
+public:
+    // Слушает socket_path; сокет, оставшийся по этому пути, удаляется, а если там другой
+    // файл, бросает std::invalid_argument
+    explicit MutationPublisher(const std::string& socket_path, const MutationPublisherOptions& options = {});
+    ~MutationPublisher();
+
+    MutationPublisher(const MutationPublisher&) = delete;
+    MutationPublisher& operator=(const MutationPublisher&) = delete;
+
+    // Возвращают номер опубликованного изменения; номера идут подряд с 1
+    uint64_t PublishAdd(uint32_t document_id, const std::vector<std::string_view>& words, DocumentStatus status, const std::vector<int>& ratings);
+    uint64_t PublishRemove(uint32_t document_id);
+
+    uint64_t GetLastSequence() const;
+    MutationPublisherStats GetStats() const;
+
+private:
+    struct Follower {
+        int fd = -1;
+        // смещение в потоке следующего неотправленного байта; пока реплика не прислала
+        // номер первого нужного изменения, равно NO_OFFSET
+        uint64_t offset;
+    };
+    static constexpr uint64_t NO_OFFSET = UINT64_MAX;
+
+    const std::string socket_path_;
+    const MutationPublisherOptions options_;
+    int listen_fd_ = -1;
+
+    mutable std::mutex mutex_;
+    // кадры потока начиная со смещения backlog_begin_
+    std::string backlog_;
+    uint64_t backlog_begin_ = 0;
+    // смещения кадров с номерами first_sequence_, first_sequence_ + 1, ...
+    std::deque<uint64_t> frame_offsets_;
+    uint64_t first_sequence_ = 1;
+    uint64_t last_sequence_ = 0;
+    bool stopping_ = false;
+    MutationPublisherStats stats_;
+
+    // меняется только потоком отправки
+    std::vector<Follower> followers_;
+    std::thread sender_;
+
+    uint64_t Publish(const std::string& payload);
+    void TrimBacklog();
+    void RunSender();
+    void AcceptFollowers();
+    // Читает номер первого нужного изменения или обнаруживает отключение; false, если
+    // реплику нужно отключить
+    bool ReceiveFromFollower(Follower& follower);
+    bool SendToFollower(Follower& follower);
+};
+
+struct MutationRecord {
+    uint64_t sequence = 0;
+    WalRecord record;
+};
+
+struct MutationSubscriberOptions {
+    // пауза перед повторным подключением и наибольшее время ожидания данных,
+    // после которого проверяется остановка
+    std::chrono::milliseconds retry_interval{ 20 };
+};
+
+// Принимает поток изменений в фоновом потоке и передаёт visitor все целые кадры,
+// полученные одним чтением, одной пачкой по порядку номеров. При обрыве или
+// повреждённом кадре переподключается и запрашивает поток с первого непереданного номера.
+// Если visitor бросает исключение, приём останавливается, а исключение возвращает GetError.
+class MutationSubscriber {
+public:
+    using BatchVisitor = std::function<void(const std::vector<MutationRecord>&)>;
+
+    MutationSubscriber(const std::string& socket_path, uint64_t next_sequence, BatchVisitor visitor, const MutationSubscriberOptions& options = {});
+    ~MutationSubscriber();
+
+    MutationSubscriber(const MutationSubscriber&) = delete;
+    MutationSubscriber& operator=(const MutationSubscriber&) = delete;
+
+    bool IsConnected() const;
+    std::exception_ptr GetError() const;
+
+private:
+    const std::string socket_path_;
+    const MutationSubscriberOptions options_;
+    const BatchVisitor visitor_;
+    uint64_t next_sequence_;
+    int fd_ = -1;
+    std::atomic<bool> is_connected_ = false;
+    std::atomic<bool> stopping_ = false;
+    mutable std::mutex error_mutex_;
+    std::exception_ptr error_;
+    std::thread receiver_;
+
+    bool Connect();
+    void Disconnect();
+    void RunReceiver();
+};
@@ -1,4 +1,8 @@
 #pragma once
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <utility>
 #include <vector>
 
 template <typename Iterator>
@@ -38,6 +42,54 @@ private:
 template <typename Container>
 auto Paginate(const Container& c, size_t page_size);
 
+// Запрашивает страницы у источника по мере обхода, не разбивая заранее готовый контейнер.
+// fetch_page(nullptr) возвращает первую страницу, fetch_page(&last) — страницу,
+// следующую за элементом last. Пустая страница означает конец выдачи.
+template <typename Item, typename FetchPage>
+class LazyPaginator {
+public:
+    class PageIterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::vector<Item>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        PageIterator() = default;
+
+        explicit PageIterator(const FetchPage* fetch_page);
+
+        reference operator*() const;
+
+        pointer operator->() const;
+
+        PageIterator& operator++();
+
+        bool operator==(const PageIterator& other) const;
+
+        bool operator!=(const PageIterator& other) const;
+
+    private:
+        const FetchPage* fetch_page_ = nullptr;
+        std::vector<Item> page_;
+
+        void Fetch(const Item* last_item);
+    };
+
+    explicit LazyPaginator(FetchPage fetch_page);
+
+    PageIterator begin() const;
+
+    PageIterator end() const;
+
+private:
+    FetchPage fetch_page_;
+};
+
+template <typename Item, typename FetchPage>
+auto PaginateLazily(FetchPage fetch_page);
+
 template <typename Iterator>
 IteratorRange<Iterator>::IteratorRange(Iterator begin, Iterator end)
     : first_(begin)
@@ -98,4 +150,65 @@ size_t Paginator<Iterator>::size() const {
 template <typename Container>
 auto Paginate(const Container& c, size_t page_size) {
     return Paginator(begin(c), end(c), page_size);
+}
+
+template <typename Item, typename FetchPage>
+LazyPaginator<Item, FetchPage>::PageIterator::PageIterator(const FetchPage* fetch_page)
+    : fetch_page_(fetch_page) {
+    Fetch(nullptr);
+}
+
+template <typename Item, typename FetchPage>
+void LazyPaginator<Item, FetchPage>::PageIterator::Fetch(const Item* last_item) {
+    page_ = (*fetch_page_)(last_item);
+    if (page_.empty()) {
+        fetch_page_ = nullptr;
+    }
+}
+
+template <typename Item, typename FetchPage>
+typename LazyPaginator<Item, FetchPage>::PageIterator::reference LazyPaginator<Item, FetchPage>::PageIterator::operator*() const {
+    return page_;
+}
+
+template <typename Item, typename FetchPage>
+typename LazyPaginator<Item, FetchPage>::PageIterator::pointer LazyPaginator<Item, FetchPage>::PageIterator::operator->() const {
+    return &page_;
+}
+
+template <typename Item, typename FetchPage>
+typename LazyPaginator<Item, FetchPage>::PageIterator& LazyPaginator<Item, FetchPage>::PageIterator::operator++() {
+    const Item last_item = page_.back();
+    Fetch(&last_item);
+    return *this;
+}
+
+template <typename Item, typename FetchPage>
+bool LazyPaginator<Item, FetchPage>::PageIterator::operator==(const PageIterator& other) const {
+    return fetch_page_ == nullptr && other.fetch_page_ == nullptr;
+}
+
+template <typename Item, typename FetchPage>
+bool LazyPaginator<Item, FetchPage>::PageIterator::operator!=(const PageIterator& other) const {
+    return !(*this == other);
+}
+
+template <typename Item, typename FetchPage>
+LazyPaginator<Item, FetchPage>::LazyPaginator(FetchPage fetch_page)
+    : fetch_page_(std::move(fetch_page)) {
+}
+
+template <typename Item, typename FetchPage>
+typename LazyPaginator<Item, FetchPage>::PageIterator LazyPaginator<Item, FetchPage>::begin() const {
+    return PageIterator(&fetch_page_);
+}
+
+template <typename Item, typename FetchPage>
+typename LazyPaginator<Item, FetchPage>::PageIterator LazyPaginator<Item, FetchPage>::end() const {
+    return PageIterator();
+}
+
+template <typename Item, typename FetchPage>
+auto PaginateLazily(FetchPage fetch_page) {
+    return LazyPaginator<Item, FetchPage>(std::move(fetch_page));
 }
\ No newline at end of file
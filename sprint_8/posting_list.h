@@ -0,0 +1,453 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Список документов слова в виде двух параллельных массивов, упорядоченных по id.
+// Удаление обнуляет частоту и оставляет id на месте, поэтому не сдвигает массивы;
+// настоящая частота всегда положительна. Когда удалённых становится больше половины,
+// массивы уплотняются.
+//
+// Список слова, встречающегося в большой доле документов, можно перевести в битовое
+// представление: бит на каждый id до наибольшего и байт квантованной частоты на
+// документ. Частоты тогда должны лежать в (0, 1] и хранятся с точностью 1 / MAX_LEVEL.
+template <typename DocumentId, typename Frequency>
+class PostingList
+{
+public:
+    static constexpr uint32_t MAX_LEVEL = 255;
+
+    // Позиция продолжаемого обхода VisitBefore
+    struct Cursor
+    {
+        size_t position = 0;
+        size_t rank = 0;
+    };
+
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<DocumentId, Frequency>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(const PostingList* list, size_t position)
+            : list_(list), position_(position)
+        {
+            SkipRemoved();
+        }
+
+        value_type operator*() const
+        {
+            if (list_->is_bitmap_)
+            {
+                return { static_cast<DocumentId>(position_), Dequantize(list_->levels_[rank_]) };
+            }
+            return { list_->document_ids_[position_], list_->frequencies_[position_] };
+        }
+        Iterator& operator++()
+        {
+            ++position_;
+            rank_ += list_->is_bitmap_;
+            SkipRemoved();
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return position_ == other.position_; }
+        bool operator!=(const Iterator& other) const { return position_ != other.position_; }
+
+    private:
+        const PostingList* list_;
+        size_t position_;
+        // Число документов до position_ в битовом представлении; итератор создаётся
+        // только в начале и в конце списка
+        size_t rank_ = 0;
+
+        void SkipRemoved()
+        {
+            if (list_->is_bitmap_)
+            {
+                position_ = list_->FindNextBit(position_);
+                return;
+            }
+            while (position_ < list_->frequencies_.size() && list_->frequencies_[position_] == Frequency{})
+            {
+                ++position_;
+            }
+        }
+    };
+
+    void Set(DocumentId document_id, Frequency frequency)
+    {
+        if (is_bitmap_)
+        {
+            SetBit(document_id, Quantize(frequency));
+            return;
+        }
+        if (document_ids_.empty() || document_ids_.back() < document_id)
+        {
+            document_ids_.push_back(document_id);
+            frequencies_.push_back(frequency);
+            ++size_;
+            return;
+        }
+        const size_t position = LowerBound(document_id);
+        if (position < document_ids_.size() && document_ids_[position] == document_id)
+        {
+            size_ += frequencies_[position] == Frequency{};
+            frequencies_[position] = frequency;
+            return;
+        }
+        document_ids_.insert(document_ids_.begin() + position, document_id);
+        frequencies_.insert(frequencies_.begin() + position, frequency);
+        ++size_;
+    }
+
+    void Erase(DocumentId document_id)
+    {
+        if (is_bitmap_)
+        {
+            ResetBit(document_id);
+            return;
+        }
+        const size_t position = LowerBound(document_id);
+        if (position == document_ids_.size() || document_ids_[position] != document_id || frequencies_[position] == Frequency{})
+        {
+            return;
+        }
+        frequencies_[position] = Frequency{};
+        --size_;
+        if (size_ * 2 < document_ids_.size())
+        {
+            Compact();
+        }
+    }
+
+    // document_ids упорядочены по возрастанию и не повторяются. Немногие документы
+    // удаляются по одному, иначе список фильтруется за один проход
+    void EraseSorted(const std::vector<DocumentId>& document_ids)
+    {
+        if (document_ids.size() * ERASE_SCAN_RATIO < size_)
+        {
+            for (const DocumentId document_id : document_ids)
+            {
+                Erase(document_id);
+            }
+            return;
+        }
+        if (is_bitmap_)
+        {
+            EraseSortedBits(document_ids);
+            return;
+        }
+        size_t kept = 0;
+        auto removed = document_ids.begin();
+        for (size_t i = 0; i < document_ids_.size(); ++i)
+        {
+            while (removed != document_ids.end() && *removed < document_ids_[i])
+            {
+                ++removed;
+            }
+            if (frequencies_[i] == Frequency{} || (removed != document_ids.end() && *removed == document_ids_[i]))
+            {
+                continue;
+            }
+            document_ids_[kept] = document_ids_[i];
+            frequencies_[kept] = frequencies_[i];
+            ++kept;
+        }
+        document_ids_.resize(kept);
+        frequencies_.resize(kept);
+        size_ = kept;
+    }
+
+    // Частота документа или ноль, если его нет в списке
+    Frequency Find(DocumentId document_id) const
+    {
+        if (is_bitmap_)
+        {
+            const size_t index = static_cast<size_t>(document_id);
+            if (index / BITS_PER_WORD >= bits_.size() || (bits_[index / BITS_PER_WORD] & Mask(index)) == 0)
+            {
+                return Frequency{};
+            }
+            return Dequantize(levels_[Rank(index)]);
+        }
+        const size_t position = LowerBound(document_id);
+        if (position == document_ids_.size() || document_ids_[position] != document_id)
+        {
+            return Frequency{};
+        }
+        return frequencies_[position];
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    Iterator begin() const { return { this, 0 }; }
+    Iterator end() const { return { this, is_bitmap_ ? bits_.size() * BITS_PER_WORD : document_ids_.size() }; }
+
+    // Передаёт visitor(id, частота) документы с id меньше last, начиная с места, где
+    // остановился предыдущий вызов с тем же cursor
+    template <typename Visitor>
+    void VisitBefore(Cursor& cursor, DocumentId last, Visitor visitor) const
+    {
+        if (!is_bitmap_)
+        {
+            for (; cursor.position < document_ids_.size() && document_ids_[cursor.position] < last; ++cursor.position)
+            {
+                if (frequencies_[cursor.position] != Frequency{})
+                {
+                    visitor(document_ids_[cursor.position], frequencies_[cursor.position]);
+                }
+            }
+            return;
+        }
+        const size_t end = std::min(static_cast<size_t>(last), bits_.size() * BITS_PER_WORD);
+        while (cursor.position < end)
+        {
+            const uint64_t word = bits_[cursor.position / BITS_PER_WORD] >> (cursor.position % BITS_PER_WORD);
+            if (word == 0)
+            {
+                cursor.position = (cursor.position / BITS_PER_WORD + 1) * BITS_PER_WORD;
+                continue;
+            }
+            cursor.position += __builtin_ctzll(word);
+            if (cursor.position >= end)
+            {
+                break;
+            }
+            visitor(static_cast<DocumentId>(cursor.position), Dequantize(levels_[cursor.rank]));
+            ++cursor.position;
+            ++cursor.rank;
+        }
+    }
+
+    template <typename Visitor>
+    void ForEach(Visitor visitor) const
+    {
+        if (!is_bitmap_)
+        {
+            Cursor cursor;
+            VisitBefore(cursor, std::numeric_limits<DocumentId>::max(), visitor);
+            return;
+        }
+        size_t rank = 0;
+        for (size_t i = 0; i < bits_.size(); ++i)
+        {
+            for (uint64_t word = bits_[i]; word != 0; word &= word - 1)
+            {
+                visitor(static_cast<DocumentId>(i * BITS_PER_WORD + __builtin_ctzll(word)), Dequantize(levels_[rank++]));
+            }
+        }
+    }
+
+    bool IsBitmap() const { return is_bitmap_; }
+
+    void ConvertToBitmap()
+    {
+        if (is_bitmap_)
+        {
+            return;
+        }
+        const std::vector<DocumentId> document_ids = std::move(document_ids_);
+        const std::vector<Frequency> frequencies = std::move(frequencies_);
+        document_ids_ = {};
+        frequencies_ = {};
+        size_ = 0;
+        is_bitmap_ = true;
+        if (!document_ids.empty())
+        {
+            Grow(static_cast<size_t>(document_ids.back()));
+        }
+        levels_.reserve(document_ids.size());
+        for (size_t i = 0; i < document_ids.size(); ++i)
+        {
+            if (frequencies[i] != Frequency{})
+            {
+                SetBit(document_ids[i], Quantize(frequencies[i]));
+            }
+        }
+    }
+
+    // Занятая списком память без учёта самого объекта
+    size_t GetMemoryUsage() const
+    {
+        return document_ids_.capacity() * sizeof(DocumentId) + frequencies_.capacity() * sizeof(Frequency)
+            + bits_.capacity() * sizeof(uint64_t) + word_ranks_.capacity() * sizeof(uint32_t) + levels_.capacity();
+    }
+
+    // Сырые массивы вместе с удалёнными позициями (их частота равна нулю); в битовом
+    // представлении пусты
+    size_t GetCapacity() const { return document_ids_.size(); }
+    const DocumentId* GetDocumentIds() const { return document_ids_.data(); }
+    const Frequency* GetFrequencies() const { return frequencies_.data(); }
+
+private:
+    static constexpr size_t BITS_PER_WORD = 64;
+    // Удаление по одному дешевле прохода по списку, пока удаляемых меньше 1/ERASE_SCAN_RATIO
+    static constexpr size_t ERASE_SCAN_RATIO = 16;
+
+    std::vector<DocumentId> document_ids_;
+    std::vector<Frequency> frequencies_;
+    size_t size_ = 0;
+
+    bool is_bitmap_ = false;
+    std::vector<uint64_t> bits_;
+    // Число документов в словах bits_ до данного
+    std::vector<uint32_t> word_ranks_;
+    // Квантованные частоты документов в порядке id
+    std::vector<uint8_t> levels_;
+
+    size_t LowerBound(DocumentId document_id) const
+    {
+        return std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id) - document_ids_.begin();
+    }
+
+    void Compact()
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < document_ids_.size(); ++i)
+        {
+            if (frequencies_[i] != Frequency{})
+            {
+                document_ids_[kept] = document_ids_[i];
+                frequencies_[kept] = frequencies_[i];
+                ++kept;
+            }
+        }
+        document_ids_.resize(kept);
+        frequencies_.resize(kept);
+    }
+
+    static uint64_t Mask(size_t index)
+    {
+        return uint64_t{ 1 } << (index % BITS_PER_WORD);
+    }
+
+    static uint8_t Quantize(Frequency frequency)
+    {
+        const long level = std::lround(frequency * static_cast<double>(MAX_LEVEL));
+        return static_cast<uint8_t>(std::clamp<long>(level, 1, MAX_LEVEL));
+    }
+
+    static Frequency Dequantize(uint8_t level)
+    {
+        return static_cast<Frequency>(level * (1.0 / MAX_LEVEL));
+    }
+
+    size_t Rank(size_t index) const
+    {
+        return word_ranks_[index / BITS_PER_WORD] + __builtin_popcountll(bits_[index / BITS_PER_WORD] & (Mask(index) - 1));
+    }
+
+    size_t FindNextBit(size_t index) const
+    {
+        const size_t end = bits_.size() * BITS_PER_WORD;
+        while (index < end)
+        {
+            const uint64_t word = bits_[index / BITS_PER_WORD] >> (index % BITS_PER_WORD);
+            if (word != 0)
+            {
+                return index + __builtin_ctzll(word);
+            }
+            index = (index / BITS_PER_WORD + 1) * BITS_PER_WORD;
+        }
+        return end;
+    }
+
+    void Grow(size_t index)
+    {
+        if (index / BITS_PER_WORD >= bits_.size())
+        {
+            bits_.resize(index / BITS_PER_WORD + 1, 0);
+            word_ranks_.resize(bits_.size(), static_cast<uint32_t>(size_));
+        }
+    }
+
+    // Вставка в середину сдвигает частоты и счётчики следующих слов
+    void SetBit(DocumentId document_id, uint8_t level)
+    {
+        const size_t index = static_cast<size_t>(document_id);
+        Grow(index);
+        const size_t rank = Rank(index);
+        uint64_t& word = bits_[index / BITS_PER_WORD];
+        if ((word & Mask(index)) != 0)
+        {
+            levels_[rank] = level;
+            return;
+        }
+        word |= Mask(index);
+        levels_.insert(levels_.begin() + rank, level);
+        for (size_t i = index / BITS_PER_WORD + 1; i < word_ranks_.size(); ++i)
+        {
+            ++word_ranks_[i];
+        }
+        ++size_;
+    }
+
+    void EraseSortedBits(const std::vector<DocumentId>& document_ids)
+    {
+        std::vector<size_t> removed_ranks;
+        for (const DocumentId document_id : document_ids)
+        {
+            const size_t index = static_cast<size_t>(document_id);
+            if (index / BITS_PER_WORD < bits_.size() && (bits_[index / BITS_PER_WORD] & Mask(index)) != 0)
+            {
+                removed_ranks.push_back(Rank(index));
+            }
+        }
+        for (const DocumentId document_id : document_ids)
+        {
+            const size_t index = static_cast<size_t>(document_id);
+            if (index / BITS_PER_WORD < bits_.size())
+            {
+                bits_[index / BITS_PER_WORD] &= ~Mask(index);
+            }
+        }
+
+        size_t kept = 0;
+        auto removed = removed_ranks.begin();
+        for (size_t rank = 0; rank < levels_.size(); ++rank)
+        {
+            if (removed != removed_ranks.end() && *removed == rank)
+            {
+                ++removed;
+                continue;
+            }
+            levels_[kept++] = levels_[rank];
+        }
+        levels_.resize(kept);
+        size_ = kept;
+
+        uint32_t rank = 0;
+        for (size_t i = 0; i < bits_.size(); ++i)
+        {
+            word_ranks_[i] = rank;
+            rank += __builtin_popcountll(bits_[i]);
+        }
+    }
+
+    void ResetBit(DocumentId document_id)
+    {
+        const size_t index = static_cast<size_t>(document_id);
+        if (index / BITS_PER_WORD >= bits_.size() || (bits_[index / BITS_PER_WORD] & Mask(index)) == 0)
+        {
+            return;
+        }
+        levels_.erase(levels_.begin() + Rank(index));
+        bits_[index / BITS_PER_WORD] &= ~Mask(index);
+        for (size_t i = index / BITS_PER_WORD + 1; i < word_ranks_.size(); ++i)
+        {
+            --word_ranks_[i];
+        }
+        --size_;
+    }
+};
@@ -16,6 +16,13 @@ vector<vector<Document>> ProcessQueries(
     return result;
 }
 
+vector<vector<Document>> ProcessQueriesShared(
+    const SearchServer& search_server,
+    const vector<string>& queries)
+{
+    return search_server.FindTopDocumentsBatch(queries);
+}
+
 list<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const vector<string>& queries)
@@ -10,6 +10,11 @@ std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
+// То же, что ProcessQueries, но через общий для пакета обход списков документов
+std::vector<std::vector<Document>> ProcessQueriesShared(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries);
+
 std::list<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
\ No newline at end of file
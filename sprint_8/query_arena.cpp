@@ -0,0 +1,68 @@
+#include "query_arena.h"
+
+QueryArena::CountingResource::CountingResource(std::pmr::memory_resource* upstream)
+    : upstream_(upstream) {
+}
+
+void* QueryArena::CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    ++allocation_count;
+    allocated_bytes += bytes;
+    return upstream_->allocate(bytes, alignment);
+}
+
+void QueryArena::CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    upstream_->deallocate(p, bytes, alignment);
+}
+
+bool QueryArena::CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+QueryArena::QueryArena()
+    : initial_buffer_(std::make_unique<std::byte[]>(INITIAL_BUFFER_SIZE))
+    , upstream_(std::pmr::new_delete_resource())
+    , buffer_(initial_buffer_.get(), INITIAL_BUFFER_SIZE, &upstream_)
+    , front_(&buffer_) {
+}
+
+QueryArena& QueryArena::ForCurrentThread() {
+    thread_local QueryArena arena;
+    return arena;
+}
+
+std::pmr::memory_resource* QueryArena::Resource() {
+    return &front_;
+}
+
+void QueryArena::Enter() {
+    ++depth_;
+}
+
+void QueryArena::Leave() {
+    if (--depth_ > 0) {
+        return;
+    }
+    last_query_stats_ = { front_.allocation_count, front_.allocated_bytes, upstream_.allocation_count };
+    front_.allocation_count = 0;
+    front_.allocated_bytes = 0;
+    upstream_.allocation_count = 0;
+    upstream_.allocated_bytes = 0;
+    buffer_.release();
+}
+
+QueryAllocationStats QueryArena::GetLastQueryStats() const {
+    return last_query_stats_;
+}
+
+QueryArenaScope::QueryArenaScope()
+    : arena_(QueryArena::ForCurrentThread()) {
+    arena_.Enter();
+}
+
+QueryArenaScope::~QueryArenaScope() {
+    arena_.Leave();
+}
+
+std::pmr::memory_resource* QueryArenaScope::Resource() const {
+    return arena_.Resource();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+struct QueryAllocationStats {
+    // выделения памяти, обслуженные ареной (без неё каждое ушло бы в глобальную кучу)
+    size_t arena_allocations = 0;
+    size_t arena_bytes = 0;
+    // обращения самой арены к глобальной куче за новыми блоками
+    size_t upstream_allocations = 0;
+};
+
+// Монотонный буфер потока для временных данных одного запроса. Память освобождается
+// целиком, когда завершается самый внешний QueryArenaScope потока.
+class QueryArena {
+public:
+    static QueryArena& ForCurrentThread();
+
+    std::pmr::memory_resource* Resource();
+
+    void Enter();
+    void Leave();
+
+    QueryAllocationStats GetLastQueryStats() const;
+
+    QueryArena(const QueryArena&) = delete;
+    QueryArena& operator=(const QueryArena&) = delete;
+
+private:
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        explicit CountingResource(std::pmr::memory_resource* upstream);
+
+        size_t allocation_count = 0;
+        size_t allocated_bytes = 0;
+
+    private:
+        std::pmr::memory_resource* upstream_;
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    static const size_t INITIAL_BUFFER_SIZE = 64 * 1024;
+
+    QueryArena();
+
+    std::unique_ptr<std::byte[]> initial_buffer_;
+    CountingResource upstream_;
+    std::pmr::monotonic_buffer_resource buffer_;
+    CountingResource front_;
+    int depth_ = 0;
+    QueryAllocationStats last_query_stats_;
+};
+
+class QueryArenaScope {
+public:
+    QueryArenaScope();
+    ~QueryArenaScope();
+
+    QueryArenaScope(const QueryArenaScope&) = delete;
+    QueryArenaScope& operator=(const QueryArenaScope&) = delete;
+
+    std::pmr::memory_resource* Resource() const;
+
+private:
+    QueryArena& arena_;
+};
@@ -0,0 +1,38 @@
+#include "query_plan.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+void PrintTerms(std::ostream& out, const std::pmr::vector<PlannedTerm>& terms) {
+    out << "["s;
+    bool is_first = true;
+    for (const PlannedTerm& term : terms) {
+        if (!is_first) {
+            out << ", "s;
+        }
+        is_first = false;
+        out << term.word << " (df = "s << term.document_freq << ", idf = "s << term.inverse_document_freq << ")"s;
+    }
+    out << "]"s;
+}
+
+}
+
+QueryPlan::QueryPlan(std::pmr::memory_resource* resource)
+    : plus_terms(resource)
+    , zero_weight_terms(resource)
+    , minus_terms(resource)
+    , excluded_documents(resource) {
+}
+
+std::ostream& operator<<(std::ostream& out, const QueryPlan& plan) {
+    out << "{ plus_terms = "s;
+    PrintTerms(out, plan.plus_terms);
+    out << ", zero_weight_terms = "s;
+    PrintTerms(out, plan.zero_weight_terms);
+    out << ", minus_terms = "s;
+    PrintTerms(out, plan.minus_terms);
+    out << ", excluded_documents = "s << plan.excluded_document_count << " }"s;
+    return out;
+}
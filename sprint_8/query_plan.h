@@ -0,0 +1,30 @@
+#pragma once
+
+#include <iostream>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+#include "document_bitmap.h"
+
+struct PlannedTerm {
+    std::string_view word;
+    int term_id = -1;
+    size_t document_freq = 0;
+    double inverse_document_freq = 0.0;
+};
+
+struct QueryPlan {
+    explicit QueryPlan(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // упорядочены по возрастанию document_freq: редкие слова обходятся первыми
+    std::pmr::vector<PlannedTerm> plus_terms;
+    // слова с нулевым IDF (встречаются во всех документах) не влияют на релевантность,
+    // но по-прежнему определяют, какие документы найдены
+    std::pmr::vector<PlannedTerm> zero_weight_terms;
+    std::pmr::vector<PlannedTerm> minus_terms;
+    DocumentBitmap excluded_documents;
+    size_t excluded_document_count = 0;
+};
+
+std::ostream& operator<<(std::ostream& out, const QueryPlan& plan);
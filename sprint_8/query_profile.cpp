@@ -0,0 +1,52 @@
+#include "query_profile.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+void PrintTerms(std::ostream& out, const std::vector<ProfiledTerm>& terms) {
+    out << "["s;
+    bool is_first = true;
+    for (const ProfiledTerm& term : terms) {
+        if (!is_first) {
+            out << ", "s;
+        }
+        is_first = false;
+        out << term.word << " ("s << term.posting_count << ")"s;
+    }
+    out << "]"s;
+}
+
+int64_t ToMicroseconds(std::chrono::nanoseconds duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+}
+
+std::ostream& operator<<(std::ostream& out, QueryExecutionPath path) {
+    switch (path) {
+    case QueryExecutionPath::SEQUENTIAL:
+        return out << "SEQUENTIAL"s;
+    case QueryExecutionPath::DENSE:
+        return out << "DENSE"s;
+    case QueryExecutionPath::PARALLEL:
+        return out << "PARALLEL"s;
+    case QueryExecutionPath::IMPACT:
+        return out << "IMPACT"s;
+    }
+    return out;
+}
+
+std::ostream& operator<<(std::ostream& out, const QueryProfile& profile) {
+    out << "{ plus_terms = "s;
+    PrintTerms(out, profile.plus_terms);
+    out << ", minus_terms = "s;
+    PrintTerms(out, profile.minus_terms);
+    out << ", path = "s << profile.path << ", postings_scanned = "s << profile.postings_scanned
+        << ", predicate_calls = "s << profile.predicate_calls << ", excluded_documents = "s << profile.excluded_documents
+        << ", accumulator_size = "s << profile.accumulator_size << ", lock_acquisitions = "s << profile.lock_acquisitions
+        << ", parse = "s << ToMicroseconds(profile.parse_time) << " us, plan = "s << ToMicroseconds(profile.plan_time)
+        << " us, score = "s << ToMicroseconds(profile.score_time) << " us, select = "s << ToMicroseconds(profile.select_time)
+        << " us }"s;
+    return out;
+}
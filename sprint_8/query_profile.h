@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+enum class QueryExecutionPath {
+    SEQUENTIAL,
+    DENSE,
+    PARALLEL,
+    IMPACT,
+};
+
+struct ProfiledTerm {
+    std::string word;
+    size_t posting_count = 0;
+};
+
+// Счётчики работы одного запроса. Заполняются только перегрузками поиска,
+// которым передан профиль; обычные перегрузки ничего не считают.
+struct QueryProfile {
+    // слова после исключения стоп-слов и повторов; слова без документов — с posting_count = 0
+    std::vector<ProfiledTerm> plus_terms;
+    std::vector<ProfiledTerm> minus_terms;
+
+    QueryExecutionPath path = QueryExecutionPath::SEQUENTIAL;
+    // прочитанных при подсчёте вхождений; массивы списков читаются вместе с освобождёнными местами
+    uint64_t postings_scanned = 0;
+    uint64_t predicate_calls = 0;
+    uint64_t excluded_documents = 0;
+    // элементов в аккумуляторе релевантностей; у плотного — все порядковые номера документов
+    size_t accumulator_size = 0;
+    // захватов мьютексов корзин аккумулятора в параллельном выполнении
+    uint64_t lock_acquisitions = 0;
+
+    std::chrono::nanoseconds parse_time{};
+    std::chrono::nanoseconds plan_time{};
+    std::chrono::nanoseconds score_time{};
+    std::chrono::nanoseconds select_time{};
+};
+
+std::ostream& operator<<(std::ostream& out, QueryExecutionPath path);
+std::ostream& operator<<(std::ostream& out, const QueryProfile& profile);
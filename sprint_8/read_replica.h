@@ -0,0 +1,130 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mutation_stream.h"
+#include "search_server.h"
+
+// Реплика только для чтения: применяет к server поток изменений пишущего сервера
+// (см. BasicSearchServer::OpenMutationPublisher) пачками под исключительной
+// блокировкой, а чтения выполняет под разделяемой. server должен быть пуст и
+// меняться только репликой. Если изменение не удалось применить, реплика перестаёт
+// принимать поток, а ожидания и чтения бросают исключение применения.
+template <typename Traits>
+class ReadReplica {
+public:
+    using Server = BasicSearchServer<Traits>;
+
+    ReadReplica(BasicSearchServer<Traits>& server, const std::string& socket_path, const MutationSubscriberOptions& options = {})
+        : server_(server)
+    {
+        if (server_.GetDocumentCount() != 0) {
+            throw std::invalid_argument("Replica server must be empty"s);
+        }
+        subscriber_ = std::make_unique<MutationSubscriber>(socket_path, applied_sequence_ + 1, [this](const std::vector<MutationRecord>& batch) {
+            ApplyBatch(batch);
+        }, options);
+    }
+
+    ~ReadReplica() {
+        // останавливает применение до разрушения остальных полей
+        subscriber_.reset();
+    }
+
+    ReadReplica(const ReadReplica&) = delete;
+    ReadReplica& operator=(const ReadReplica&) = delete;
+
+    uint64_t GetAppliedSequence() const {
+        std::lock_guard lock(sequence_mutex_);
+        return applied_sequence_;
+    }
+
+    bool IsConnected() const {
+        return subscriber_->IsConnected();
+    }
+
+    // Исключение, на котором остановилось применение изменений, или nullptr
+    std::exception_ptr GetError() const {
+        std::lock_guard lock(sequence_mutex_);
+        return error_;
+    }
+
+    // false, если за timeout реплика не применила изменение sequence
+    bool WaitForSequence(uint64_t sequence, std::chrono::milliseconds timeout) const {
+        std::unique_lock lock(sequence_mutex_);
+        const bool is_applied = sequence_applied_.wait_for(lock, timeout, [this, sequence] {
+            return error_ || applied_sequence_ >= sequence;
+        });
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        return is_applied;
+    }
+
+    // Вызывает reader(const Server&), когда применены все изменения до min_sequence
+    // включительно, и возвращает его результат. Бросает std::out_of_range, если реплика
+    // не дошла до min_sequence за timeout
+    template <typename Reader>
+    auto Read(uint64_t min_sequence, std::chrono::milliseconds timeout, Reader reader) const {
+        if (!WaitForSequence(min_sequence, timeout)) {
+            throw std::out_of_range("Replica has not applied mutation "s + std::to_string(min_sequence));
+        }
+        std::shared_lock lock(server_mutex_);
+        // применение могло прерваться, пока блокировка ожидалась, и оставить пачку применённой частично
+        if (const std::exception_ptr error = GetError()) {
+            std::rethrow_exception(error);
+        }
+        return reader(static_cast<const Server&>(server_));
+    }
+
+private:
+    Server& server_;
+    mutable std::shared_mutex server_mutex_;
+
+    mutable std::mutex sequence_mutex_;
+    mutable std::condition_variable sequence_applied_;
+    uint64_t applied_sequence_ = 0;
+    std::exception_ptr error_;
+
+    std::unique_ptr<MutationSubscriber> subscriber_;
+
+    // Номер применённого изменения сдвигается только после всей пачки. Исключение
+    // записывается до снятия блокировки сервера и передаётся подписчику, который
+    // после него останавливается
+    void ApplyBatch(const std::vector<MutationRecord>& batch) {
+        {
+            std::unique_lock lock(server_mutex_);
+            try {
+                for (const auto& [sequence, record] : batch) {
+                    const auto document_id = static_cast<typename Server::DocumentId>(record.document_id);
+                    if (record.type == WalRecordType::ADD_DOCUMENT) {
+                        server_.AddTokenizedDocument(document_id, record.words, record.status, record.ratings);
+                    } else {
+                        server_.RemoveDocument(document_id);
+                    }
+                }
+            } catch (...) {
+                {
+                    std::lock_guard sequence_lock(sequence_mutex_);
+                    error_ = std::current_exception();
+                }
+                sequence_applied_.notify_all();
+                throw;
+            }
+        }
+        {
+            std::lock_guard lock(sequence_mutex_);
+            applied_sequence_ = batch.back().sequence;
+        }
+        sequence_applied_.notify_all();
+    }
+};
@@ -4,9 +4,7 @@ RequestQueue::RequestQueue(const SearchServer& search_server) : search_server_(s
 }
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) {
-    return AddFindRequest(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-        });
+    return AddFindRequest(raw_query, DocumentFilter{ status });
 }
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query) {
@@ -15,4 +13,8 @@ std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query)
 
 int RequestQueue::GetNoResultRequests() const {
     return std::count(requests_.begin(), requests_.end(), 0);
+}
+
+int RequestQueue::GetRequestCount() const {
+    return static_cast<int>(requests_.size());
 }
\ No newline at end of file
@@ -18,6 +18,8 @@ public:
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status);
     std::vector<Document> AddFindRequest(const std::string& raw_query);
     int GetNoResultRequests() const;
+    // Число запросов в окне, по которому считается GetNoResultRequests
+    int GetRequestCount() const;
 
 private:
     struct QueryResult {/*она не особо нужна*/ };
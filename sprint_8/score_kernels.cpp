@@ -0,0 +1,261 @@
+#include "score_kernels.h"
+
+// Релевантность должна совпадать до бита при любом наборе инструкций, поэтому
+// умножение и сложение не сливаются в FMA, доступную вместе с AVX-512
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SCORE_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+template <typename Score>
+void AccumulateScalar(const uint32_t* document_ids, const Score* frequencies, size_t count, Score inverse_document_freq, Score* accumulator)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        accumulator[document_ids[i]] += frequencies[i] * inverse_document_freq;
+    }
+}
+
+template <typename Score>
+size_t CollectAboveScalar(const Score* values, size_t count, Score threshold, uint32_t* positions)
+{
+    size_t found = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (values[i] > threshold)
+        {
+            positions[found++] = static_cast<uint32_t>(i);
+        }
+    }
+    return found;
+}
+
+#ifdef SCORE_KERNELS_X86
+
+size_t AppendMaskedPositions(unsigned mask, size_t first, uint32_t* positions)
+{
+    size_t found = 0;
+    while (mask != 0)
+    {
+        positions[found++] = static_cast<uint32_t>(first + __builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+    return found;
+}
+
+// В AVX2 нет scatter: суммы собираются gather, а записываются обратно по одной.
+// Маскированный gather с нулевой основой нужен только чтобы не читать неопределённый регистр
+__attribute__((target("avx2")))
+void AccumulateAvx2(const uint32_t* document_ids, const double* frequencies, size_t count, double inverse_document_freq, double* accumulator)
+{
+    const __m256d idf = _mm256_set1_pd(inverse_document_freq);
+    alignas(32) double sums[4];
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(document_ids + i));
+        const __m256d current = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), accumulator, index, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), sizeof(double));
+        _mm256_store_pd(sums, _mm256_add_pd(current, _mm256_mul_pd(_mm256_loadu_pd(frequencies + i), idf)));
+        for (size_t lane = 0; lane < 4; ++lane)
+        {
+            accumulator[document_ids[i + lane]] = sums[lane];
+        }
+    }
+    AccumulateScalar(document_ids + i, frequencies + i, count - i, inverse_document_freq, accumulator);
+}
+
+__attribute__((target("avx2")))
+void AccumulateAvx2(const uint32_t* document_ids, const float* frequencies, size_t count, float inverse_document_freq, float* accumulator)
+{
+    const __m256 idf = _mm256_set1_ps(inverse_document_freq);
+    alignas(32) float sums[8];
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(document_ids + i));
+        const __m256 current = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), accumulator, index, _mm256_castsi256_ps(_mm256_set1_epi32(-1)), sizeof(float));
+        _mm256_store_ps(sums, _mm256_add_ps(current, _mm256_mul_ps(_mm256_loadu_ps(frequencies + i), idf)));
+        for (size_t lane = 0; lane < 8; ++lane)
+        {
+            accumulator[document_ids[i + lane]] = sums[lane];
+        }
+    }
+    AccumulateScalar(document_ids + i, frequencies + i, count - i, inverse_document_freq, accumulator);
+}
+
+__attribute__((target("avx2")))
+size_t CollectAboveAvx2(const double* values, size_t count, double threshold, uint32_t* positions)
+{
+    const __m256d limit = _mm256_set1_pd(threshold);
+    size_t found = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const unsigned mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values + i), limit, _CMP_GT_OQ));
+        found += AppendMaskedPositions(mask, i, positions + found);
+    }
+    const size_t tail = CollectAboveScalar(values + i, count - i, threshold, positions + found);
+    for (size_t j = found; j < found + tail; ++j)
+    {
+        positions[j] += static_cast<uint32_t>(i);
+    }
+    return found + tail;
+}
+
+__attribute__((target("avx2")))
+size_t CollectAboveAvx2(const float* values, size_t count, float threshold, uint32_t* positions)
+{
+    const __m256 limit = _mm256_set1_ps(threshold);
+    size_t found = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const unsigned mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), limit, _CMP_GT_OQ));
+        found += AppendMaskedPositions(mask, i, positions + found);
+    }
+    const size_t tail = CollectAboveScalar(values + i, count - i, threshold, positions + found);
+    for (size_t j = found; j < found + tail; ++j)
+    {
+        positions[j] += static_cast<uint32_t>(i);
+    }
+    return found + tail;
+}
+
+__attribute__((target("avx512f")))
+void AccumulateAvx512(const uint32_t* document_ids, const double* frequencies, size_t count, double inverse_document_freq, double* accumulator)
+{
+    const __m512d idf = _mm512_set1_pd(inverse_document_freq);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(document_ids + i));
+        const __m512d current = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, index, accumulator, sizeof(double));
+        const __m512d sum = _mm512_add_pd(current, _mm512_mul_pd(_mm512_loadu_pd(frequencies + i), idf));
+        _mm512_i32scatter_pd(accumulator, index, sum, sizeof(double));
+    }
+    AccumulateScalar(document_ids + i, frequencies + i, count - i, inverse_document_freq, accumulator);
+}
+
+__attribute__((target("avx512f")))
+void AccumulateAvx512(const uint32_t* document_ids, const float* frequencies, size_t count, float inverse_document_freq, float* accumulator)
+{
+    const __m512 idf = _mm512_set1_ps(inverse_document_freq);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m512i index = _mm512_loadu_si512(document_ids + i);
+        const __m512 current = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, index, accumulator, sizeof(float));
+        const __m512 sum = _mm512_add_ps(current, _mm512_mul_ps(_mm512_loadu_ps(frequencies + i), idf));
+        _mm512_i32scatter_ps(accumulator, index, sum, sizeof(float));
+    }
+    AccumulateScalar(document_ids + i, frequencies + i, count - i, inverse_document_freq, accumulator);
+}
+
+__attribute__((target("avx512f")))
+size_t CollectAboveAvx512(const double* values, size_t count, double threshold, uint32_t* positions)
+{
+    const __m512d limit = _mm512_set1_pd(threshold);
+    size_t found = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const unsigned mask = _mm512_cmp_pd_mask(_mm512_loadu_pd(values + i), limit, _CMP_GT_OQ);
+        found += AppendMaskedPositions(mask, i, positions + found);
+    }
+    const size_t tail = CollectAboveScalar(values + i, count - i, threshold, positions + found);
+    for (size_t j = found; j < found + tail; ++j)
+    {
+        positions[j] += static_cast<uint32_t>(i);
+    }
+    return found + tail;
+}
+
+__attribute__((target("avx512f")))
+size_t CollectAboveAvx512(const float* values, size_t count, float threshold, uint32_t* positions)
+{
+    const __m512 limit = _mm512_set1_ps(threshold);
+    size_t found = 0;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const unsigned mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(values + i), limit, _CMP_GT_OQ);
+        found += AppendMaskedPositions(mask, i, positions + found);
+    }
+    const size_t tail = CollectAboveScalar(values + i, count - i, threshold, positions + found);
+    for (size_t j = found; j < found + tail; ++j)
+    {
+        positions[j] += static_cast<uint32_t>(i);
+    }
+    return found + tail;
+}
+
+#endif
+
+}
+
+ScoreKernelIsa DetectScoreKernelIsa()
+{
+    if (IsScoreKernelIsaSupported(ScoreKernelIsa::AVX512))
+    {
+        return ScoreKernelIsa::AVX512;
+    }
+    if (IsScoreKernelIsaSupported(ScoreKernelIsa::AVX2))
+    {
+        return ScoreKernelIsa::AVX2;
+    }
+    return ScoreKernelIsa::SCALAR;
+}
+
+bool IsScoreKernelIsaSupported(ScoreKernelIsa isa)
+{
+    switch (isa)
+    {
+    case ScoreKernelIsa::SCALAR:
+        return true;
+#ifdef SCORE_KERNELS_X86
+    case ScoreKernelIsa::AVX2:
+        return __builtin_cpu_supports("avx2");
+    case ScoreKernelIsa::AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+template <typename Score>
+const ScoreKernels<Score>& GetScoreKernels(ScoreKernelIsa isa)
+{
+    static const ScoreKernels<Score> scalar{ AccumulateScalar<Score>, CollectAboveScalar<Score>, ScoreKernelIsa::SCALAR };
+#ifdef SCORE_KERNELS_X86
+    static const ScoreKernels<Score> avx2{ AccumulateAvx2, CollectAboveAvx2, ScoreKernelIsa::AVX2 };
+    static const ScoreKernels<Score> avx512{ AccumulateAvx512, CollectAboveAvx512, ScoreKernelIsa::AVX512 };
+    if (isa == ScoreKernelIsa::AVX512 && IsScoreKernelIsaSupported(isa))
+    {
+        return avx512;
+    }
+    if (isa == ScoreKernelIsa::AVX2 && IsScoreKernelIsaSupported(isa))
+    {
+        return avx2;
+    }
+#endif
+    return scalar;
+}
+
+template <typename Score>
+const ScoreKernels<Score>& GetScoreKernels()
+{
+    static const ScoreKernels<Score>& kernels = GetScoreKernels<Score>(DetectScoreKernelIsa());
+    return kernels;
+}
+
+template const ScoreKernels<double>& GetScoreKernels<double>(ScoreKernelIsa isa);
+template const ScoreKernels<float>& GetScoreKernels<float>(ScoreKernelIsa isa);
+template const ScoreKernels<double>& GetScoreKernels<double>();
+template const ScoreKernels<float>& GetScoreKernels<float>();
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+enum class ScoreKernelIsa {
+    SCALAR,
+    AVX2,
+    AVX512,
+};
+
+// Ядра подсчёта релевантности над плотным массивом-аккумулятором, индексированным id документа.
+// Определены для double и float.
+template <typename Score>
+struct ScoreKernels {
+    // accumulator[document_ids[i]] += frequencies[i] * inverse_document_freq;
+    // id внутри одного вызова не повторяются
+    void (*accumulate)(const uint32_t* document_ids, const Score* frequencies, size_t count, Score inverse_document_freq, Score* accumulator);
+    // Записывает в positions позиции элементов values больше threshold и возвращает их число
+    size_t (*collect_above)(const Score* values, size_t count, Score threshold, uint32_t* positions);
+    ScoreKernelIsa isa;
+};
+
+// Самый широкий набор инструкций, который поддерживает процессор
+ScoreKernelIsa DetectScoreKernelIsa();
+bool IsScoreKernelIsaSupported(ScoreKernelIsa isa);
+
+template <typename Score>
+const ScoreKernels<Score>& GetScoreKernels(ScoreKernelIsa isa);
+// Ядра для DetectScoreKernelIsa(), выбираются один раз
+template <typename Score>
+const ScoreKernels<Score>& GetScoreKernels();
@@ -0,0 +1,23 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "paginator.h"
+#include "search_server.h"
+
+// Выдача по запросу, разбитая на страницы по page_size документов;
+// каждая следующая страница запрашивается у сервера только при переходе к ней.
+template <typename Traits>
+auto PaginateSearch(const BasicSearchServer<Traits>& search_server, const std::string_view raw_query, size_t page_size) {
+    using Document = typename BasicSearchServer<Traits>::Document;
+    using SearchCursor = typename BasicSearchServer<Traits>::SearchCursor;
+    return PaginateLazily<Document>(
+        [&search_server, query = std::string(raw_query), page_size](const Document* last_document) {
+            std::optional<SearchCursor> after;
+            if (last_document != nullptr) {
+                after = SearchCursor{ last_document->relevance, last_document->rating, last_document->id };
+            }
+            return search_server.FindDocumentsPage(query, after, page_size);
+        });
+}
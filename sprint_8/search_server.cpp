@@ -2,271 +2,1264 @@
 
 //using namespace std;
 
-SearchServer::SearchServer()
+template <typename Traits>
+BasicSearchServer<Traits>::BasicSearchServer()
 {
 }
 
-SearchServer::SearchServer(const std::string& stop_words_text)
-	: SearchServer(SplitIntoWords(stop_words_text))
+template <typename Traits>
+BasicSearchServer<Traits>::BasicSearchServer(const std::string& stop_words_text)
+	: BasicSearchServer(SplitIntoWords(stop_words_text))
 {
 }
 
-SearchServer::SearchServer(const std::string_view stop_words_text)
-	: SearchServer(SplitIntoWords(stop_words_text))
+template <typename Traits>
+BasicSearchServer<Traits>::BasicSearchServer(const std::string_view stop_words_text)
+	: BasicSearchServer(SplitIntoWords(stop_words_text))
 {
 }
 
-std::string_view SearchServer::AddUniqueWord(const std::string& word)
+template <typename Traits>
+int BasicSearchServer<Traits>::AddTerm(const std::string_view word, bool copy_word)
 {
-	return std::string_view(*(unique_words.insert(word).first));
+	const uint64_t hash = TermDictionary::Hash(word);
+	if (const int term_id = term_dictionary_.Find(word, hash); term_id != TermDictionary::NOT_FOUND)
+	{
+		return term_id;
+	}
+
+	std::string_view stored_word = word;
+	if (shared_vocabulary_)
+	{
+		stored_word = shared_vocabulary_->Intern(word, hash);
+	}
+	else if (copy_word)
+	{
+		stored_word = *unique_words.emplace(word).first;
+	}
+	const int term_id = static_cast<int>(term_id_to_word_.size());
+	term_dictionary_.Insert(stored_word, hash, term_id);
+	term_id_to_word_.push_back(stored_word);
+	term_postings_.emplace_back();
+	if (!shared_vocabulary_)
+	{
+		term_trie_.Insert(stored_word, term_id);
+	}
+	standing_query_index_.BindWord(stored_word, term_id);
+	return term_id;
 }
 
-void SearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings)
+template <typename Traits>
+void BasicSearchServer<Traits>::AddDocument(DocumentId document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings)
 {
-	if ((document_id < 0) || (documents_.count(document_id) > 0))
+	AddTokenizedDocument(document_id, SplitIntoWords(document), status, ratings);
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::AddTokenizedDocument(DocumentId document_id, const std::vector<std::string_view>& words, DocumentStatus status, const std::vector<int>& ratings,
+	const std::shared_ptr<const void>& word_storage)
+{
+	if ((std::is_signed_v<DocumentId> && document_id < DocumentId{}) || document_table_.Find(document_id) != nullptr)
 	{
 		throw std::invalid_argument("Invalid document_id"s);
 	}
 
-	const auto words = SplitIntoWordsNoStop(document);
+	const auto document_words = FilterWordsNoStop(words);
+
+	// Запись попадает в журнал до изменения индекса, чтобы ошибка журнала не оставила
+	// в индексе документ, добавление которого завершилось исключением
+	if (write_ahead_log_)
+	{
+		write_ahead_log_->AppendAdd(document_id, document_words, status, ratings);
+	}
+
+	if (word_storage && !shared_vocabulary_ && (word_storages_.empty() || word_storages_.back() != word_storage))
+	{
+		word_storages_.push_back(word_storage);
+	}
+
+	std::vector<int> word_term_ids;
+	word_term_ids.reserve(document_words.size());
+	for (const std::string_view word : document_words)
+	{
+		word_term_ids.push_back(AddTerm(word, word_storage == nullptr));
+	}
+	std::sort(word_term_ids.begin(), word_term_ids.end());
+
+	const Ordinal ordinal = document_table_.Add(document_id, ComputeAverageRating(ratings), status);
+	const Score inv_word_count = static_cast<Score>(1.0 / document_words.size());
+
+	std::vector<TermFrequency<Score>> term_freqs;
+	std::vector<int> document_term_ids;
+	for (auto it = word_term_ids.begin(); it != word_term_ids.end();)
+	{
+		TermFrequency<Score> term_freq{ *it, 0 };
+		for (; it != word_term_ids.end() && *it == term_freq.term_id; ++it)
+		{
+			term_freq.frequency += inv_word_count;
+		}
+		if (const auto dropped = dropped_term_freqs_.find(term_freq.term_id); dropped != dropped_term_freqs_.end())
+		{
+			++dropped->second;
+		}
+		else
+		{
+			term_postings_[term_freq.term_id].Set(ordinal, term_freq.frequency);
+		}
+		term_freqs.push_back(term_freq);
+		document_term_ids.push_back(term_freq.term_id);
+	}
+
+	forward_index_.Add(ordinal, term_freqs);
+	if (is_near_duplicate_detection_enabled_)
+	{
+		min_hash_index_.Add(ordinal, document_term_ids);
+	}
+	impact_index_.Clear();
+
+	if (high_frequency_term_options_.mode != HighFrequencyTermMode::KEEP)
+	{
+		for (const int term_id : document_term_ids)
+		{
+			UpdateHighFrequencyTerm(term_id);
+		}
+	}
+
+	if (mutation_publisher_)
+	{
+		mutation_publisher_->PublishAdd(document_id, document_words, status, ratings);
+	}
+
+	if (standing_query_callback_ && !standing_query_index_.empty())
+	{
+		if (const std::vector<StandingQueryMatch> matches = PercolateOrdinal(ordinal); !matches.empty())
+		{
+			standing_query_callback_(document_id, matches);
+		}
+	}
+}
+
+template <typename Traits>
+size_t BasicSearchServer<Traits>::OpenWriteAheadLog(const std::string& path, const WriteAheadLogOptions& options)
+{
+	if (write_ahead_log_)
+	{
+		throw std::invalid_argument("Write-ahead log is already open"s);
+	}
+
+	size_t record_count = 0;
+	const size_t valid_size = WriteAheadLog::Replay(path, [this, &record_count](const WalRecord& record)
+		{
+			if (record.type == WalRecordType::ADD_DOCUMENT)
+			{
+				AddTokenizedDocument(record.document_id, record.words, record.status, record.ratings);
+			}
+			else
+			{
+				RemoveDocument(record.document_id);
+			}
+			++record_count;
+		});
+
+	write_ahead_log_ = std::make_unique<WriteAheadLog>(path, valid_size, options);
+	return record_count;
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::SyncWriteAheadLog()
+{
+	if (write_ahead_log_)
+	{
+		write_ahead_log_->Sync();
+	}
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::CheckpointWriteAheadLog(const std::function<void(const BasicSearchServer&)>& save_snapshot)
+{
+	if (!write_ahead_log_)
+	{
+		throw std::invalid_argument("Write-ahead log is not open"s);
+	}
+	write_ahead_log_->Sync();
+	save_snapshot(*this);
+	write_ahead_log_->Truncate();
+}
+
+template <typename Traits>
+WriteAheadLogStats BasicSearchServer<Traits>::GetWriteAheadLogStats() const
+{
+	return write_ahead_log_ ? write_ahead_log_->GetStats() : WriteAheadLogStats{};
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::OpenMutationPublisher(const std::string& socket_path, const MutationPublisherOptions& options)
+{
+	if (mutation_publisher_)
+	{
+		throw std::invalid_argument("Mutation publisher is already open"s);
+	}
+	if (document_table_.GetCapacity() != 0)
+	{
+		throw std::invalid_argument("Mutation publisher must be opened before documents are added"s);
+	}
+	mutation_publisher_ = std::make_unique<MutationPublisher>(socket_path, options);
+}
+
+template <typename Traits>
+uint64_t BasicSearchServer<Traits>::GetMutationSequence() const
+{
+	return mutation_publisher_ ? mutation_publisher_->GetLastSequence() : 0;
+}
 
-	std::unordered_set<std::string_view> document_words;
+template <typename Traits>
+MutationPublisherStats BasicSearchServer<Traits>::GetMutationPublisherStats() const
+{
+	return mutation_publisher_ ? mutation_publisher_->GetStats() : MutationPublisherStats{};
+}
 
-	const double inv_word_count = 1.0 / words.size();
+template <typename Traits>
+void BasicSearchServer<Traits>::SetTermExpansionOptions(const TermExpansionOptions& options)
+{
+	term_expansion_options_ = options;
+}
 
-	for (const auto& word : words)
+template <typename Traits>
+void BasicSearchServer<Traits>::SetSharedVocabulary(std::shared_ptr<SharedVocabulary> vocabulary)
+{
+	if (!term_id_to_word_.empty())
 	{
-		const std::string_view current_word = AddUniqueWord(std::string(word));
+		throw std::invalid_argument("Shared vocabulary must be set before adding documents"s);
+	}
+	shared_vocabulary_ = std::move(vocabulary);
+}
 
-		document_to_word_freqs_[document_id][word] += inv_word_count;
-		word_to_document_freqs_[current_word][document_id] += inv_word_count;
+template <typename Traits>
+void BasicSearchServer<Traits>::BuildImpactIndex()
+{
+	impact_index_.Build(term_postings_, GetDocumentCount());
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::SetImpactSearchOptions(const ImpactSearchOptions& options)
+{
+	impact_search_options_ = options;
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::SetLongQueryOptions(const LongQueryOptions& options)
+{
+	long_query_options_ = options;
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::SetHighFrequencyTermOptions(const HighFrequencyTermOptions& options)
+{
+	if (!(options.min_document_fraction >= 0.0 && options.min_document_fraction <= 1.0))
+	{
+		throw std::invalid_argument("High-frequency term fraction must be within [0, 1]"s);
+	}
+	high_frequency_term_options_ = options;
 
-		document_words.insert(current_word);
+	const std::vector<int> high_frequency_term_ids(high_frequency_term_ids_.begin(), high_frequency_term_ids_.end());
+	for (const int term_id : high_frequency_term_ids)
+	{
+		RestorePostings(term_id);
+	}
+	if (options.mode != HighFrequencyTermMode::KEEP)
+	{
+		for (int term_id = 0; term_id < static_cast<int>(term_postings_.size()); ++term_id)
+		{
+			UpdateHighFrequencyTerm(term_id);
+		}
+	}
+	impact_index_.Clear();
+}
+
+template <typename Traits>
+HighFrequencyTermReport BasicSearchServer<Traits>::GetHighFrequencyTermReport() const
+{
+	HighFrequencyTermReport report;
+	for (const int term_id : high_frequency_term_ids_)
+	{
+		const auto dropped = dropped_term_freqs_.find(term_id);
+		const auto& postings = term_postings_[term_id];
+		HighFrequencyTerm term;
+		term.word = term_id_to_word_[term_id];
+		term.document_freq = dropped == dropped_term_freqs_.end() ? postings.size() : dropped->second;
+		term.array_bytes = term.document_freq * (sizeof(Ordinal) + sizeof(Score));
+		term.bytes = postings.GetMemoryUsage();
+		report.saved_bytes += static_cast<std::ptrdiff_t>(term.array_bytes) - static_cast<std::ptrdiff_t>(term.bytes);
+		report.terms.push_back(term);
+	}
+	return report;
+}
+
+template <typename Traits>
+size_t BasicSearchServer<Traits>::GetHighFrequencyThreshold() const
+{
+	const auto fraction_count = static_cast<size_t>(std::ceil(high_frequency_term_options_.min_document_fraction * GetDocumentCount()));
+	return std::max({ high_frequency_term_options_.min_document_count, fraction_count, size_t{ 1 } });
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::UpdateHighFrequencyTerm(int term_id)
+{
+	PostingList<Ordinal, Score>& postings = term_postings_[term_id];
+	const auto dropped = dropped_term_freqs_.find(term_id);
+	const size_t document_freq = dropped == dropped_term_freqs_.end() ? postings.size() : dropped->second;
+	const size_t threshold = GetHighFrequencyThreshold();
+
+	if (high_frequency_term_ids_.count(term_id) > 0)
+	{
+		if (high_frequency_term_options_.mode == HighFrequencyTermMode::KEEP || document_freq * 2 < threshold)
+		{
+			RestorePostings(term_id);
+		}
+		return;
+	}
+	if (high_frequency_term_options_.mode == HighFrequencyTermMode::KEEP || document_freq < threshold)
+	{
+		return;
+	}
+
+	high_frequency_term_ids_.insert(term_id);
+	if (high_frequency_term_options_.mode == HighFrequencyTermMode::BITMAP)
+	{
+		postings.ConvertToBitmap();
+	}
+	else
+	{
+		dropped_term_freqs_.emplace(term_id, document_freq);
+		postings = {};
+	}
+	impact_index_.Clear();
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::RestorePostings(int term_id)
+{
+	const auto is_before = [](const TermFrequency<Score>& term_freq, int term_id)
+	{
+		return term_freq.term_id < term_id;
+	};
+
+	PostingList<Ordinal, Score> postings;
+	for (size_t ordinal = 0; ordinal < document_table_.GetCapacity(); ++ordinal)
+	{
+		if (!document_table_.IsAlive(static_cast<Ordinal>(ordinal)))
+		{
+			continue;
+		}
+		const TermFrequencies<Score> term_freqs = forward_index_.Get(static_cast<Ordinal>(ordinal));
+		const auto term_freq = std::lower_bound(term_freqs.begin(), term_freqs.end(), term_id, is_before);
+		if (term_freq != term_freqs.end() && term_freq->term_id == term_id)
+		{
+			postings.Set(static_cast<Ordinal>(ordinal), term_freq->frequency);
+		}
+	}
+
+	term_postings_[term_id] = std::move(postings);
+	dropped_term_freqs_.erase(term_id);
+	high_frequency_term_ids_.erase(term_id);
+	impact_index_.Clear();
+}
+
+template <typename Traits>
+std::vector<int> BasicSearchServer<Traits>::CollectHighFrequencyTerms(Ordinal ordinal) const
+{
+	std::vector<int> term_ids;
+	if (high_frequency_term_ids_.empty())
+	{
+		return term_ids;
+	}
+	for (const TermFrequency<Score>& term_freq : forward_index_.Get(ordinal))
+	{
+		if (high_frequency_term_ids_.count(term_freq.term_id) > 0)
+		{
+			term_ids.push_back(term_freq.term_id);
+		}
+	}
+	return term_ids;
+}
+
+template <typename Traits>
+bool BasicSearchServer<Traits>::IsDroppedTerm(int term_id) const
+{
+	return !dropped_term_freqs_.empty() && dropped_term_freqs_.count(term_id) > 0;
+}
+
+template <typename Traits>
+bool BasicSearchServer<Traits>::IsExpandableTerm(int term_id) const
+{
+	return !IsDroppedTerm(term_id) && !term_postings_[term_id].empty();
+}
+
+template <typename Traits>
+bool BasicSearchServer<Traits>::HasDocuments(int term_id) const
+{
+	if (!term_postings_[term_id].empty())
+	{
+		return true;
+	}
+	const auto dropped = dropped_term_freqs_.find(term_id);
+	return dropped != dropped_term_freqs_.end() && dropped->second > 0;
+}
+
+template <typename Traits>
+bool BasicSearchServer<Traits>::IsImpactSearchActive() const
+{
+	return impact_search_options_.enabled && impact_index_.IsBuilt();
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(const std::string_view raw_query, const DocumentFilter& filter) const
+{
+	return FindTopMatchedDocuments(raw_query, [this, &filter](Ordinal ordinal)
+		{ return MatchesFilter(filter, ordinal); });
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(std::execution::sequenced_policy, const std::string_view raw_query, const DocumentFilter& filter) const
+{
+	return FindTopMatchedDocuments(std::execution::seq, raw_query, [this, &filter](Ordinal ordinal)
+		{ return MatchesFilter(filter, ordinal); });
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(std::execution::parallel_policy, const std::string_view raw_query, const DocumentFilter& filter) const
+{
+	return FindTopMatchedDocuments(std::execution::par, raw_query, [this, &filter](Ordinal ordinal)
+		{ return MatchesFilter(filter, ordinal); });
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(std::execution::sequenced_policy, const std::string_view raw_query, const DocumentFilter& filter, QueryProfile& profile) const
+{
+	return ProfileTopMatchedDocuments(ExecutionMode::SEQUENTIAL, raw_query, [this, &filter](Ordinal ordinal)
+		{ return MatchesFilter(filter, ordinal); }, profile);
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(std::execution::parallel_policy, const std::string_view raw_query, const DocumentFilter& filter, QueryProfile& profile) const
+{
+	return ProfileTopMatchedDocuments(ExecutionMode::PARALLEL, raw_query, [this, &filter](Ordinal ordinal)
+		{ return MatchesFilter(filter, ordinal); }, profile);
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(const std::string_view raw_query, const DocumentFilter& filter, QueryProfile& profile) const
+{
+	return ProfileTopMatchedDocuments(std::nullopt, raw_query, [this, &filter](Ordinal ordinal)
+		{ return MatchesFilter(filter, ordinal); }, profile);
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(const std::string_view raw_query, QueryProfile& profile) const
+{
+	return FindTopDocuments(raw_query, DocumentFilter{ DocumentStatus::ACTUAL }, profile);
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(const std::string_view raw_query, DocumentStatus status) const
+{
+	return FindTopDocuments(raw_query, DocumentFilter{ status });
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(std::execution::sequenced_policy, const std::string_view raw_query, DocumentStatus status) const
+{
+	return FindTopDocuments(std::execution::seq, raw_query, DocumentFilter{ status });
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(std::execution::parallel_policy, const std::string_view raw_query, DocumentStatus status) const
+{
+	return FindTopDocuments(std::execution::par, raw_query, DocumentFilter{ status });
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(const std::string_view raw_query) const
+{
+	return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(std::execution::sequenced_policy, const std::string_view raw_query) const
+{
+	return FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(std::execution::parallel_policy, const std::string_view raw_query) const
+{
+	return FindTopDocuments(std::execution::par, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindDocumentsPage(const std::string_view raw_query, const std::optional<SearchCursor>& after, size_t page_size, const DocumentFilter& filter) const
+{
+	return FindMatchedDocumentsPage(raw_query, after, page_size, [this, &filter](Ordinal ordinal)
+		{ return MatchesFilter(filter, ordinal); });
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindDocumentsPage(const std::string_view raw_query, const std::optional<SearchCursor>& after, size_t page_size) const
+{
+	return FindDocumentsPage(raw_query, after, page_size, DocumentFilter{ DocumentStatus::ACTUAL });
+}
+
+template <typename Traits>
+std::vector<std::vector<typename BasicSearchServer<Traits>::Document>> BasicSearchServer<Traits>::FindTopDocumentsBatch(const std::vector<std::string>& raw_queries, const DocumentFilter& filter) const
+{
+	std::vector<std::vector<Document>> results(raw_queries.size());
+	if (IsImpactSearchActive())
+	{
+		std::transform(raw_queries.begin(), raw_queries.end(), results.begin(), [this, &filter](const std::string& raw_query)
+			{ return FindTopDocuments(raw_query, filter); });
+		return results;
+	}
+
+	const QueryArenaScope arena;
+
+	// Ключ плана — id его термов по группам; -1 разделяет группы
+	std::vector<QueryPlan> plans;
+	std::vector<size_t> query_to_plan(raw_queries.size());
+	std::map<std::vector<int>, size_t> plan_indexes;
+	for (size_t i = 0; i < raw_queries.size(); ++i)
+	{
+		QueryPlan plan = PlanQuery(ParseQuery(raw_queries[i], arena.Resource()), arena.Resource());
+		std::vector<int> key;
+		for (const auto* terms : { &plan.plus_terms, &plan.zero_weight_terms, &plan.minus_terms })
+		{
+			for (const PlannedTerm& term : *terms)
+			{
+				key.push_back(term.term_id);
+			}
+			key.push_back(-1);
+		}
+		const auto [it, inserted] = plan_indexes.emplace(std::move(key), plans.size());
+		if (inserted)
+		{
+			plans.push_back(std::move(plan));
+		}
+		query_to_plan[i] = it->second;
+	}
+
+	struct SharedTerm
+	{
+		const PlannedTerm* term;
+		const PostingList<Ordinal, Score>* postings;
+		std::vector<size_t> plan_indexes;
+		typename PostingList<Ordinal, Score>::Cursor cursor;
+	};
+	// В порядке (document_freq, id терма) — том же, в котором PlanQuery упорядочивает
+	// термы каждого плана, поэтому вклады в релевантность складываются в том же порядке
+	std::map<std::pair<size_t, int>, SharedTerm> plus_terms;
+	std::map<int, SharedTerm> zero_weight_terms;
+	for (size_t plan_index = 0; plan_index < plans.size(); ++plan_index)
+	{
+		for (const PlannedTerm& term : plans[plan_index].plus_terms)
+		{
+			SharedTerm& shared_term = plus_terms[{ term.document_freq, term.term_id }];
+			shared_term.term = &term;
+			shared_term.postings = &term_postings_[term.term_id];
+			shared_term.plan_indexes.push_back(plan_index);
+		}
+		for (const PlannedTerm& term : plans[plan_index].zero_weight_terms)
+		{
+			SharedTerm& shared_term = zero_weight_terms[term.term_id];
+			shared_term.term = &term;
+			shared_term.postings = &term_postings_[term.term_id];
+			shared_term.plan_indexes.push_back(plan_index);
+		}
+	}
+
+	std::vector<const DocumentBitmap*> excluded_documents;
+	for (const QueryPlan& plan : plans)
+	{
+		excluded_documents.push_back(plan.excluded_document_count > 0 ? &plan.excluded_documents : nullptr);
+	}
+
+	const size_t ordinal_count = document_table_.GetCapacity();
+	const size_t block_size = std::max(MIN_BATCH_BLOCK_SIZE, BATCH_ACCUMULATOR_SIZE / std::max<size_t>(plans.size(), 1));
+	// Отрицательная релевантность помечает документ, найденный только словами с нулевым IDF
+	std::pmr::vector<Score> accumulators(plans.size() * block_size, Score{}, arena.Resource());
+	std::vector<std::vector<uint32_t>> touched_offsets(plans.size());
+	std::vector<size_t> touched_plans;
+	// Кандидаты сразу отбираются в лучшие MAX_RESULT_DOCUMENT_COUNT: хранить все совпадения
+	// всех запросов пакета дороже, чем пройти их ещё раз
+	std::vector<std::vector<Document>> plan_documents(plans.size());
+
+	const auto touch = [&](size_t plan_index, uint32_t offset)
+	{
+		if (touched_offsets[plan_index].empty())
+		{
+			touched_plans.push_back(plan_index);
+		}
+		touched_offsets[plan_index].push_back(offset);
+	};
+
+	for (size_t first = 0; first < ordinal_count; first += block_size)
+	{
+		const size_t last = std::min(first + block_size, ordinal_count);
+
+		for (auto& [_, shared_term] : plus_terms)
+		{
+			shared_term.postings->VisitBefore(shared_term.cursor, static_cast<Ordinal>(last), [&](Ordinal ordinal, Score term_freq)
+				{
+					if (!MatchesFilter(filter, ordinal))
+					{
+						return;
+					}
+					const auto contribution = term_freq * shared_term.term->inverse_document_freq;
+					const uint32_t offset = static_cast<uint32_t>(ordinal - first);
+					for (const size_t plan_index : shared_term.plan_indexes)
+					{
+						if (excluded_documents[plan_index] != nullptr && excluded_documents[plan_index]->Test(ordinal))
+						{
+							continue;
+						}
+						Score& relevance = accumulators[plan_index * block_size + offset];
+						if (relevance == Score{})
+						{
+							touch(plan_index, offset);
+						}
+						relevance += contribution;
+					}
+				});
+		}
+
+		for (auto& [_, shared_term] : zero_weight_terms)
+		{
+			shared_term.postings->VisitBefore(shared_term.cursor, static_cast<Ordinal>(last), [&](Ordinal ordinal, Score)
+				{
+					if (!MatchesFilter(filter, ordinal))
+					{
+						return;
+					}
+					const uint32_t offset = static_cast<uint32_t>(ordinal - first);
+					for (const size_t plan_index : shared_term.plan_indexes)
+					{
+						Score& relevance = accumulators[plan_index * block_size + offset];
+						if (relevance == Score{} && (excluded_documents[plan_index] == nullptr || !excluded_documents[plan_index]->Test(ordinal)))
+						{
+							touch(plan_index, offset);
+							relevance = Score{ -1 };
+						}
+					}
+				});
+		}
+
+		for (const size_t plan_index : touched_plans)
+		{
+			std::vector<Document>& top_documents = plan_documents[plan_index];
+			for (const uint32_t offset : touched_offsets[plan_index])
+			{
+				Score& relevance = accumulators[plan_index * block_size + offset];
+				const Ordinal ordinal = static_cast<Ordinal>(first + offset);
+				const Document document{ document_table_.GetId(ordinal), std::max(relevance, Score{}), document_table_.GetRating(ordinal) };
+				relevance = Score{};
+				if (top_documents.size() == Traits::MAX_RESULT_DOCUMENT_COUNT && !IsRankedBefore(document, top_documents.back()))
+				{
+					continue;
+				}
+				top_documents.push_back(document);
+				SelectTopDocuments(top_documents);
+			}
+			touched_offsets[plan_index].clear();
+		}
+		touched_plans.clear();
+	}
+
+	for (size_t i = 0; i < raw_queries.size(); ++i)
+	{
+		results[i] = plan_documents[query_to_plan[i]];
+	}
+	return results;
+}
+
+template <typename Traits>
+std::vector<std::vector<typename BasicSearchServer<Traits>::Document>> BasicSearchServer<Traits>::FindTopDocumentsBatch(const std::vector<std::string>& raw_queries) const
+{
+	return FindTopDocumentsBatch(raw_queries, DocumentFilter{ DocumentStatus::ACTUAL });
+}
+
+template <typename Traits>
+QueryPlan BasicSearchServer<Traits>::ExplainQuery(const std::string_view raw_query) const
+{
+	return PlanQuery(ParseQuery(raw_query, std::pmr::get_default_resource()), std::pmr::get_default_resource());
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindSimilar(DocumentId document_id, const DocumentFilter& filter) const
+{
+	const Ordinal ordinal = document_table_.At(document_id);
+	const QueryArenaScope arena;
+	QueryPlan plan(arena.Resource());
+	std::pmr::vector<double> term_weights(arena.Resource());
+	for (const TermFrequency<Score>& term_freq : forward_index_.Get(ordinal))
+	{
+		// Пустой список — у слова, исключённого как частое
+		if (term_postings_[term_freq.term_id].empty())
+		{
+			continue;
+		}
+		const PlannedTerm term = PlanTerm(term_freq.term_id);
+		// слово, которое есть во всех документах, не делает документы похожими
+		if (term.inverse_document_freq == 0.0)
+		{
+			continue;
+		}
+		plan.plus_terms.push_back(term);
+		term_weights.push_back(term_freq.frequency * term.inverse_document_freq);
+	}
+	OrderPlusTerms(plan, term_weights);
+	plan.excluded_documents.Set(ordinal);
+	plan.excluded_document_count = 1;
+
+	return FindTopPlannedDocuments(plan, [this, &filter](Ordinal candidate)
+		{ return MatchesFilter(filter, candidate); }, arena.Resource());
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindSimilar(DocumentId document_id) const
+{
+	return FindSimilar(document_id, DocumentFilter{ DocumentStatus::ACTUAL });
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::AddStandingQuery(int query_id, const std::string_view raw_query)
+{
+	std::vector<StandingQueryTerm> plus_terms;
+	std::vector<StandingQueryTerm> minus_terms;
+	for (const std::string_view word : SplitIntoWords(raw_query))
+	{
+		const QueryWord query_word = ParseQueryWord(word);
+		if (query_word.is_prefix || query_word.is_fuzzy)
+		{
+			throw std::invalid_argument("Standing queries do not support prefix and fuzzy words"s);
+		}
+		if (query_word.is_stop)
+		{
+			continue;
+		}
+		// Слова, которых ещё нет в словаре, хранит индекс запросов до их первого документа
+		(query_word.is_minus ? minus_terms : plus_terms).push_back({ query_word.data, term_dictionary_.Find(query_word.data) });
 	}
+	standing_query_index_.Add(query_id, plus_terms, minus_terms);
+}
 
-	documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status, document_words });
-	document_ids_.emplace(document_id);
+template <typename Traits>
+bool BasicSearchServer<Traits>::RemoveStandingQuery(int query_id)
+{
+	return standing_query_index_.Remove(query_id);
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::SetStandingQueryCallback(std::function<void(DocumentId, const std::vector<StandingQueryMatch>&)> callback)
+{
+	standing_query_callback_ = std::move(callback);
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus status) const
+template <typename Traits>
+std::vector<StandingQueryMatch> BasicSearchServer<Traits>::MatchStandingQueries(DocumentId document_id) const
 {
-	return SearchServer::FindTopDocuments(std::execution::seq, raw_query, [status](int document_id, DocumentStatus document_status, int rating)
-		{ return document_status == status; });
+	return PercolateOrdinal(document_table_.At(document_id));
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentStatus status) const
+template <typename Traits>
+std::vector<StandingQueryMatch> BasicSearchServer<Traits>::PercolateOrdinal(Ordinal ordinal) const
 {
-	return SearchServer::FindTopDocuments(std::execution::seq, raw_query, [status](int document_id, DocumentStatus document_status, int rating)
-		{ return document_status == status; });
+	std::vector<WeightedTerm> terms;
+	for (const TermFrequency<Score>& term_freq : forward_index_.Get(ordinal))
+	{
+		// исключённые частые слова не участвуют в запросах, как и в FindTopDocuments
+		if (IsDroppedTerm(term_freq.term_id))
+		{
+			continue;
+		}
+		const double inverse_document_freq = std::log(GetDocumentCount() * 1.0 / term_postings_[term_freq.term_id].size());
+		terms.push_back({ term_freq.term_id, term_freq.frequency * inverse_document_freq });
+	}
+	return standing_query_index_.Match(terms);
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, DocumentStatus status) const
+template <typename Traits>
+void BasicSearchServer<Traits>::SetParallelThreshold(size_t parallel_threshold)
 {
-	return SearchServer::FindTopDocuments(std::execution::par, raw_query, [status](int document_id, DocumentStatus document_status, int rating)
-		{ return document_status == status; });
+	execution_planner_.SetParallelThreshold(parallel_threshold);
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query) const
+template <typename Traits>
+void BasicSearchServer<Traits>::SetOrdinalReuse(bool reuse)
 {
-	return SearchServer::FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
+	document_table_.SetFreeOrdinalReuse(reuse);
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query) const
+template <typename Traits>
+ExecutionStats BasicSearchServer<Traits>::GetExecutionStats() const
 {
-	return SearchServer::FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
+	return execution_planner_.GetStats();
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query) const
+template <typename Traits>
+size_t BasicSearchServer<Traits>::EstimatePostings(const QueryPlan& plan)
 {
-	return SearchServer::FindTopDocuments(std::execution::par, raw_query, DocumentStatus::ACTUAL);
+	size_t posting_count = 0;
+	for (const PlannedTerm& term : plan.plus_terms)
+	{
+		posting_count += term.document_freq;
+	}
+	for (const PlannedTerm& term : plan.zero_weight_terms)
+	{
+		posting_count += term.document_freq;
+	}
+	return posting_count;
 }
 
-int SearchServer::GetDocumentCount() const
+template <typename Traits>
+int BasicSearchServer<Traits>::GetDocumentCount() const
 {
-	return documents_.size();
+	return static_cast<int>(document_table_.size());
 }
 
-std::set<int>::const_iterator SearchServer::begin() const
+template <typename Traits>
+typename DocumentTable<typename BasicSearchServer<Traits>::DocumentId>::IdIterator BasicSearchServer<Traits>::begin() const
 {
-	return document_ids_.begin();
+	return document_table_.begin();
 }
 
-std::set<int>::const_iterator SearchServer::end() const
+template <typename Traits>
+typename DocumentTable<typename BasicSearchServer<Traits>::DocumentId>::IdIterator BasicSearchServer<Traits>::end() const
 {
-	return document_ids_.end();
+	return document_table_.end();
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const
+template <typename Traits>
+WordFrequencies<typename BasicSearchServer<Traits>::Score> BasicSearchServer<Traits>::GetWordFrequencies(DocumentId document_id) const
 {
-	static const std::map<std::string_view, double> empty;
-	if (documents_.count(document_id) > 0)
+	const Ordinal* ordinal = document_table_.Find(document_id);
+	if (ordinal == nullptr)
 	{
-		return document_to_word_freqs_.at(document_id);
+		return {};
 	}
-	return empty;
+	return { forward_index_.Get(*ordinal), &term_id_to_word_ };
 }
 
-void SearchServer::RemoveDocument(std::execution::parallel_policy policy, int document_id)
+template <typename Traits>
+void BasicSearchServer<Traits>::RemoveDocument(std::execution::parallel_policy, DocumentId document_id)
 {
 	{
-		if (documents_.count(document_id) == 0)
+		const Ordinal* ordinal = document_table_.Find(document_id);
+		if (ordinal == nullptr)
 		{
 			return;
 		}
+		if (write_ahead_log_)
+		{
+			write_ahead_log_->AppendRemove(static_cast<uint32_t>(document_id));
+		}
 
-		std::map<std::string_view, double> word_freq = document_to_word_freqs_[document_id];
-		std::vector<std::string_view> vs(word_freq.size());
-
-		std::transform(
-			std::execution::par,
-			word_freq.begin(), word_freq.end(),
-			vs.begin(),
-			[&](auto word)
-			{ return word.first; });
+		const TermFrequencies<Score> term_freqs = forward_index_.Get(*ordinal);
+		const std::vector<int> high_frequency_term_ids = CollectHighFrequencyTerms(*ordinal);
 
+		// Слова документа различны, поэтому потоки меняют разные списки и счётчики
 		std::for_each(
 			std::execution::par,
-			vs.begin(), vs.end(),
-			[&document_id, this](std::string_view word)
+			term_freqs.begin(), term_freqs.end(),
+			[ordinal = *ordinal, this](const TermFrequency<Score>& term_freq)
 			{
-				word_to_document_freqs_.find(word)->second.erase(document_id);
+				if (const auto dropped = dropped_term_freqs_.find(term_freq.term_id); dropped != dropped_term_freqs_.end())
+				{
+					--dropped->second;
+				}
+				else
+				{
+					term_postings_[term_freq.term_id].Erase(ordinal);
+				}
 			});
 
-		documents_.erase(document_id);
-		document_ids_.erase(document_id);
+		RemoveOrdinal(*ordinal);
+		for (const int term_id : high_frequency_term_ids)
+		{
+			UpdateHighFrequencyTerm(term_id);
+		}
 	}
 }
 
-void SearchServer::RemoveDocument(int document_id)
+template <typename Traits>
+void BasicSearchServer<Traits>::RemoveDocument(DocumentId document_id)
 {
 	RemoveDocument(std::execution::seq, document_id);
 }
 
-void SearchServer::RemoveDocument(std::execution::sequenced_policy policy, int document_id)
+template <typename Traits>
+void BasicSearchServer<Traits>::RemoveDocument(std::execution::sequenced_policy, DocumentId document_id)
 {
-	if (documents_.count(document_id) == 0)
+	const Ordinal* ordinal = document_table_.Find(document_id);
+	if (ordinal == nullptr)
 	{
 		return;
 	}
+	if (write_ahead_log_)
+	{
+		write_ahead_log_->AppendRemove(static_cast<uint32_t>(document_id));
+	}
 
-	std::for_each(
-		document_to_word_freqs_.at(document_id).begin(),
-		document_to_word_freqs_.at(document_id).end(),
-		[this, document_id](const auto& word)
+	const std::vector<int> high_frequency_term_ids = CollectHighFrequencyTerms(*ordinal);
+	for (const TermFrequency<Score>& term_freq : forward_index_.Get(*ordinal))
+	{
+		if (const auto dropped = dropped_term_freqs_.find(term_freq.term_id); dropped != dropped_term_freqs_.end())
 		{
-			word_to_document_freqs_[word.first].erase(document_id);
-		});
+			--dropped->second;
+		}
+		else
+		{
+			term_postings_[term_freq.term_id].Erase(*ordinal);
+		}
+	}
 
-	documents_.erase(document_id);
-	document_ids_.erase(document_id);
+	RemoveOrdinal(*ordinal);
+	for (const int term_id : high_frequency_term_ids)
+	{
+		UpdateHighFrequencyTerm(term_id);
+	}
 }
 
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::string_view raw_query, int document_id) const
+template <typename Traits>
+size_t BasicSearchServer<Traits>::RemoveDocuments(const std::vector<DocumentId>& document_ids)
 {
-	return MatchDocument(std::execution::seq, raw_query, document_id);
+	return RemoveDocuments(std::execution::seq, document_ids);
 }
 
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::execution::parallel_policy policy, const std::string_view raw_query, int document_id) const
+template <typename Traits>
+size_t BasicSearchServer<Traits>::RemoveDocuments(std::execution::sequenced_policy policy, const std::vector<DocumentId>& document_ids)
 {
-	const auto query = ParseQuery(raw_query);
-
-	std::vector<std::string> plus_words{ query.plus_words.begin(), query.plus_words.end() };
-	std::vector<std::string> minus_words{ query.minus_words.begin(), query.minus_words.end() };
+	return RemoveDocumentBatch(policy, document_ids);
+}
 
-	std::vector<std::string_view> matched_words;
+template <typename Traits>
+size_t BasicSearchServer<Traits>::RemoveDocuments(std::execution::parallel_policy policy, const std::vector<DocumentId>& document_ids)
+{
+	return RemoveDocumentBatch(policy, document_ids);
+}
 
-	for (const std::string_view word : documents_.at(document_id).words)
+template <typename Traits>
+template <typename ExecutionPolicy>
+size_t BasicSearchServer<Traits>::RemoveDocumentBatch(ExecutionPolicy policy, const std::vector<DocumentId>& document_ids)
+{
+	std::vector<Ordinal> ordinals;
+	DocumentBitmap is_removed;
+	for (const DocumentId document_id : document_ids)
 	{
-		if (std::find(minus_words.begin(), minus_words.end(), word) != minus_words.end())
+		const Ordinal* ordinal = document_table_.Find(document_id);
+		if (ordinal != nullptr && !is_removed.Test(*ordinal))
 		{
-			return { matched_words, documents_.at(document_id).status };
+			is_removed.Set(*ordinal);
+			ordinals.push_back(*ordinal);
 		}
 	}
+	if (ordinals.empty())
+	{
+		return 0;
+	}
+	if (write_ahead_log_)
+	{
+		std::vector<uint32_t> removed_ids;
+		removed_ids.reserve(ordinals.size());
+		for (const Ordinal ordinal : ordinals)
+		{
+			removed_ids.push_back(static_cast<uint32_t>(document_table_.GetId(ordinal)));
+		}
+		write_ahead_log_->AppendRemoves(removed_ids);
+	}
 
-	for (const std::string_view word : documents_.at(document_id).words)
+	// Номера удаляемых документов каждого слова, по возрастанию
+	std::vector<Ordinal> sorted_ordinals = ordinals;
+	std::sort(sorted_ordinals.begin(), sorted_ordinals.end());
+	std::vector<std::vector<Ordinal>> term_to_ordinals(term_id_to_word_.size());
+	std::vector<int> term_ids;
+	for (const Ordinal ordinal : sorted_ordinals)
 	{
-		if (std::find(plus_words.begin(), plus_words.end(), word) != plus_words.end())
+		for (const TermFrequency<Score>& term_freq : forward_index_.Get(ordinal))
 		{
-			matched_words.push_back(word);
+			std::vector<Ordinal>& term_ordinals = term_to_ordinals[term_freq.term_id];
+			if (term_ordinals.empty())
+			{
+				term_ids.push_back(term_freq.term_id);
+			}
+			term_ordinals.push_back(ordinal);
 		}
 	}
 
-	return { matched_words, documents_.at(document_id).status };
+	// Каждый поток меняет только список или счётчик своего терма
+	std::for_each(policy, term_ids.begin(), term_ids.end(), [this, &term_to_ordinals](int term_id)
+		{
+			if (const auto dropped = dropped_term_freqs_.find(term_id); dropped != dropped_term_freqs_.end())
+			{
+				dropped->second -= term_to_ordinals[term_id].size();
+			}
+			else
+			{
+				term_postings_[term_id].EraseSorted(term_to_ordinals[term_id]);
+			}
+		});
+
+	std::vector<int> high_frequency_term_ids;
+	for (const int term_id : term_ids)
+	{
+		if (high_frequency_term_ids_.count(term_id) > 0)
+		{
+			high_frequency_term_ids.push_back(term_id);
+		}
+	}
+	for (const Ordinal ordinal : ordinals)
+	{
+		RemoveOrdinal(ordinal);
+	}
+	for (const int term_id : high_frequency_term_ids)
+	{
+		UpdateHighFrequencyTerm(term_id);
+	}
+	return ordinals.size();
 }
 
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::execution::sequenced_policy policy, const std::string_view raw_query, int document_id) const
+// Списки документов слов к этому моменту уже очищены
+template <typename Traits>
+void BasicSearchServer<Traits>::RemoveOrdinal(Ordinal ordinal)
 {
-	auto query = ParseQuery(raw_query);
+	const DocumentId document_id = document_table_.GetId(ordinal);
+	forward_index_.Remove(ordinal);
+	if (is_near_duplicate_detection_enabled_)
+	{
+		min_hash_index_.Remove(ordinal);
+	}
+	impact_index_.Clear();
+	document_table_.Remove(ordinal);
 
-	std::set<std::string_view> matched_words;
+	if (mutation_publisher_)
+	{
+		mutation_publisher_->PublishRemove(document_id);
+	}
+}
 
-	for (const std::string_view word : query.plus_words)
+template <typename Traits>
+void BasicSearchServer<Traits>::EnableNearDuplicateDetection()
+{
+	if (is_near_duplicate_detection_enabled_)
+	{
+		return;
+	}
+	is_near_duplicate_detection_enabled_ = true;
+	std::vector<int> term_ids;
+	for (Ordinal ordinal = 0; ordinal < document_table_.GetCapacity(); ++ordinal)
 	{
-		if (documents_.at(document_id).words.count(word) == 0)
+		if (!document_table_.IsAlive(ordinal))
 		{
 			continue;
 		}
-		if (word_to_document_freqs_.at(word).count(document_id))
+		term_ids.clear();
+		for (const TermFrequency<Score>& term_freq : forward_index_.Get(ordinal))
 		{
-			matched_words.insert(word);
+			term_ids.push_back(term_freq.term_id);
 		}
+		min_hash_index_.Add(ordinal, term_ids);
+	}
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::CheckNearDuplicateDetection() const
+{
+	if (!is_near_duplicate_detection_enabled_)
+	{
+		throw std::invalid_argument("Near-duplicate detection is not enabled"s);
+	}
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::DocumentId> BasicSearchServer<Traits>::FindNearDuplicates(DocumentId document_id, double threshold) const
+{
+	CheckNearDuplicateDetection();
+	std::vector<DocumentId> duplicates;
+	const Ordinal* ordinal = document_table_.Find(document_id);
+	if (ordinal == nullptr)
+	{
+		return duplicates;
 	}
-	for (const std::string_view word : query.minus_words)
+	for (const uint32_t candidate : min_hash_index_.FindCandidates(*ordinal))
 	{
-		if (documents_.at(document_id).words.count(word) == 0)
+		if (min_hash_index_.EstimateSimilarity(*ordinal, candidate) >= threshold)
 		{
-			continue;
+			duplicates.push_back(document_table_.GetId(candidate));
 		}
-		if (word_to_document_freqs_.at(word).count(document_id))
+	}
+	std::sort(duplicates.begin(), duplicates.end());
+	return duplicates;
+}
+
+template <typename Traits>
+template <typename ExecutionPolicy>
+std::vector<typename BasicSearchServer<Traits>::DocumentId> BasicSearchServer<Traits>::RemoveDuplicateGroups(ExecutionPolicy policy, double threshold)
+{
+	CheckNearDuplicateDetection();
+	// Похожие документы всегда попадают в одну группу, поэтому группы разбираются независимо
+	std::vector<std::vector<uint32_t>> groups = min_hash_index_.GroupCandidates();
+	std::for_each(policy, groups.begin(), groups.end(), [this, threshold](std::vector<uint32_t>& group)
 		{
-			matched_words.clear();
-			break;
+			std::sort(group.begin(), group.end(), [this](uint32_t lhs, uint32_t rhs)
+				{
+					return document_table_.GetId(lhs) < document_table_.GetId(rhs);
+				});
+			group = min_hash_index_.SelectDuplicates(group, threshold);
+		});
+
+	std::vector<DocumentId> removed_ids;
+	for (const auto& duplicates : groups)
+	{
+		for (const uint32_t ordinal : duplicates)
+		{
+			removed_ids.push_back(document_table_.GetId(ordinal));
 		}
 	}
+	std::sort(removed_ids.begin(), removed_ids.end());
+	RemoveDocuments(removed_ids);
+	return removed_ids;
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::DocumentId> BasicSearchServer<Traits>::RemoveDuplicates(double threshold)
+{
+	return RemoveDuplicates(std::execution::seq, threshold);
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::DocumentId> BasicSearchServer<Traits>::RemoveDuplicates(std::execution::sequenced_policy policy, double threshold)
+{
+	return RemoveDuplicateGroups(policy, threshold);
+}
+
+template <typename Traits>
+std::vector<typename BasicSearchServer<Traits>::DocumentId> BasicSearchServer<Traits>::RemoveDuplicates(std::execution::parallel_policy policy, double threshold)
+{
+	return RemoveDuplicateGroups(policy, threshold);
+}
+
+template <typename Traits>
+std::tuple<std::vector<std::string_view>, DocumentStatus> BasicSearchServer<Traits>::MatchDocument(const std::string_view raw_query, DocumentId document_id) const
+{
+	return MatchDocument(std::execution::seq, raw_query, document_id);
+}
+
+template <typename Traits>
+std::tuple<std::vector<std::string_view>, DocumentStatus> BasicSearchServer<Traits>::MatchDocument(std::execution::parallel_policy, const std::string_view raw_query, DocumentId document_id) const
+{
+	const QueryArenaScope arena;
+	return MatchCompiledQuery(CompileQuery(raw_query, arena.Resource()), document_id);
+}
+
+template <typename Traits>
+std::tuple<std::vector<std::string_view>, DocumentStatus> BasicSearchServer<Traits>::MatchDocument(std::execution::sequenced_policy, const std::string_view raw_query, DocumentId document_id) const
+{
+	const QueryArenaScope arena;
+	return MatchCompiledQuery(CompileQuery(raw_query, arena.Resource()), document_id);
+}
+
+template <typename Traits>
+std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> BasicSearchServer<Traits>::MatchDocuments(const std::string_view raw_query, const std::vector<DocumentId>& document_ids) const
+{
+	const QueryArenaScope arena;
+	const CompiledQuery query = CompileQuery(raw_query, arena.Resource());
+
+	std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> result;
+	result.reserve(document_ids.size());
+	for (const DocumentId document_id : document_ids)
+	{
+		result.push_back(MatchCompiledQuery(query, document_id));
+	}
+	return result;
+}
 
-	std::vector<std::string_view> matched_words_vector(matched_words.size());
+template <typename Traits>
+std::tuple<std::vector<std::string_view>, DocumentStatus> BasicSearchServer<Traits>::MatchCompiledQuery(const CompiledQuery& query, DocumentId document_id) const
+{
+	const Ordinal ordinal = document_table_.At(document_id);
+	const DocumentStatus status = document_table_.GetStatus(ordinal);
+	const TermFrequencies<Score> term_freqs = forward_index_.Get(ordinal);
+	const auto is_before = [](const TermFrequency<Score>& term_freq, int term_id)
+	{
+		return term_freq.term_id < term_id;
+	};
+
+	std::vector<std::string_view> matched_words;
+
+	auto document_it = term_freqs.begin();
+	for (const int term_id : query.minus_term_ids)
+	{
+		document_it = std::lower_bound(document_it, term_freqs.end(), term_id, is_before);
+		if (document_it == term_freqs.end())
+		{
+			break;
+		}
+		if (document_it->term_id == term_id)
+		{
+			return { matched_words, status };
+		}
+	}
 
-	std::transform(
-		matched_words.begin(), matched_words.end(),
-		matched_words_vector.begin(),
-		[](auto word)
-		{ return word; });
+	document_it = term_freqs.begin();
+	for (const int term_id : query.plus_term_ids)
+	{
+		document_it = std::lower_bound(document_it, term_freqs.end(), term_id, is_before);
+		if (document_it == term_freqs.end())
+		{
+			break;
+		}
+		if (document_it->term_id == term_id)
+		{
+			matched_words.push_back(term_id_to_word_[term_id]);
+		}
+	}
+	std::sort(matched_words.begin(), matched_words.end());
 
-	return { matched_words_vector, documents_.at(document_id).status };
+	return { matched_words, status };
 }
 
-bool SearchServer::IsStopWord(const std::string& word) const
+template <typename Traits>
+bool BasicSearchServer<Traits>::IsStopWord(const std::string_view word) const
 {
 	return stop_words_.count(word) > 0;
 }
 
-bool SearchServer::IsValidWord(const std::string& word)
+template <typename Traits>
+bool BasicSearchServer<Traits>::IsValidWord(const std::string_view word)
 {
 	return std::none_of(word.begin(), word.end(), [](char c)
 		{ return c >= '\0' && c < ' '; });
 }
 
-std::deque<std::string_view> SearchServer::SplitIntoWordsNoStop(const std::string_view text) const
+template <typename Traits>
+std::vector<std::string_view> BasicSearchServer<Traits>::FilterWordsNoStop(const std::vector<std::string_view>& words) const
 {
-	std::deque<std::string_view> words;
-
-	auto vec = SplitIntoWords(text);
+	std::vector<std::string_view> result;
+	result.reserve(words.size());
 
-	for (const std::string_view word : vec)
+	for (const std::string_view word : words)
 	{
-		if (!IsValidWord(std::string(word)))
+		if (!IsValidWord(word))
 		{
 			throw std::invalid_argument("Word "s + std::string(word) + " is invalid"s);
 		}
-		if (!IsStopWord(std::string(word)))
+		if (!IsStopWord(word))
 		{
-			words.push_back(word);
+			result.push_back(word);
 		}
 	}
-	return words;
+	return result;
 }
 
-int SearchServer::ComputeAverageRating(const std::vector<int>& ratings)
+template <typename Traits>
+int BasicSearchServer<Traits>::ComputeAverageRating(const std::vector<int>& ratings)
 {
 	if (ratings.empty()) {
         return 0;
@@ -275,7 +1268,8 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings)
     return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(const std::string_view text) const
+template <typename Traits>
+typename BasicSearchServer<Traits>::QueryWord BasicSearchServer<Traits>::ParseQueryWord(const std::string_view text) const
 {
 	if (text.empty())
 	{
@@ -292,36 +1286,301 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(const std::string_view text
 		word = word.substr(1);
 	}
 
-	if (word.empty() || word[0] == '-' || !IsValidWord(std::string(word)))
+	bool is_prefix = false;
+	bool is_fuzzy = false;
+
+	if (!word.empty() && word[0] == '~')
+	{
+		is_fuzzy = true;
+		word = word.substr(1);
+	}
+	else if (!word.empty() && word.back() == '*')
+	{
+		is_prefix = true;
+		word.remove_suffix(1);
+	}
+
+	if (word.empty() || word[0] == '-' || !IsValidWord(word))
+	{
+		throw std::invalid_argument("Query word "s + std::string(text) + " is invalid");
+	}
+
+	const bool is_stop = !is_prefix && !is_fuzzy && IsStopWord(word);
+	return { word, is_minus, is_stop, is_prefix, is_fuzzy };
+}
+
+template <typename Traits>
+std::vector<int> BasicSearchServer<Traits>::ExpandQueryWord(const QueryWord& query_word) const
+{
+	if (!shared_vocabulary_)
 	{
-		throw std::invalid_argument("Query word "s + std::string(word) + " is invalid");
+		const auto is_expandable = [this](int term_id)
+			{
+				return IsExpandableTerm(term_id);
+			};
+		if (query_word.is_prefix)
+		{
+			return term_trie_.FindByPrefix(query_word.data, term_expansion_options_.max_expansions, is_expandable);
+		}
+		return term_trie_.FindWithinDistance(query_word.data, term_expansion_options_.max_edit_distance, term_expansion_options_.max_expansions,
+			is_expandable);
 	}
 
-	return { word, is_minus, IsStopWord(std::string(word)) };
+	// Общий словарь раскрывает слово по всем серверам; ограничение max_expansions
+	// применяется только к словам этого сервера, которые могут войти в запрос
+	const auto is_local = [this](std::string_view word)
+		{
+			const int term_id = term_dictionary_.Find(word);
+			return term_id != TermDictionary::NOT_FOUND && IsExpandableTerm(term_id);
+		};
+	const std::vector<std::string_view> words = query_word.is_prefix
+		? shared_vocabulary_->FindByPrefix(query_word.data, term_expansion_options_.max_expansions, is_local)
+		: shared_vocabulary_->FindWithinDistance(query_word.data, term_expansion_options_.max_edit_distance, term_expansion_options_.max_expansions,
+			is_local);
+	std::vector<int> term_ids;
+	term_ids.reserve(words.size());
+	for (const std::string_view word : words)
+	{
+		term_ids.push_back(term_dictionary_.Find(word));
+	}
+	return term_ids;
 }
 
-SearchServer::Query SearchServer::ParseQuery(const std::string_view text) const
+template <typename Traits>
+typename BasicSearchServer<Traits>::Query BasicSearchServer<Traits>::ParseQuery(const std::string_view text, std::pmr::memory_resource* resource) const
 {
-	SearchServer::Query result;
-	for (const auto word : SplitIntoWords(text))
+	Query result(resource);
+	for (const auto word : SplitIntoWords(text, resource))
 	{
 		const auto query_word = ParseQueryWord(word);
-		if (!query_word.is_stop)
+		if (query_word.is_stop)
+		{
+			continue;
+		}
+
+		auto& term_ids = query_word.is_minus ? result.minus_term_ids : result.plus_term_ids;
+		if (query_word.is_prefix || query_word.is_fuzzy)
+		{
+			const std::vector<int> expanded_term_ids = ExpandQueryWord(query_word);
+			term_ids.insert(term_ids.end(), expanded_term_ids.begin(), expanded_term_ids.end());
+		}
+		else if (const int term_id = term_dictionary_.Find(query_word.data); term_id != TermDictionary::NOT_FOUND && !IsDroppedTerm(term_id))
+		{
+			term_ids.push_back(term_id);
+		}
+	}
+	return result;
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::AddUnknownProfiledTerms(const std::string_view raw_query, QueryProfile& profile) const
+{
+	for (const std::string_view word : SplitIntoWords(raw_query))
+	{
+		const QueryWord query_word = ParseQueryWord(word);
+		if (query_word.is_stop)
+		{
+			continue;
+		}
+		bool is_unknown = false;
+		if (query_word.is_prefix || query_word.is_fuzzy)
+		{
+			is_unknown = ExpandQueryWord(query_word).empty();
+		}
+		else
+		{
+			const int term_id = term_dictionary_.Find(query_word.data);
+			is_unknown = term_id == TermDictionary::NOT_FOUND || !HasDocuments(term_id);
+		}
+		// префиксное и нечёткое слово попадают в профиль вместе со своим знаком
+		const std::string profiled_word(query_word.is_minus ? word.substr(1) : word);
+		auto& terms = query_word.is_minus ? profile.minus_terms : profile.plus_terms;
+		if (is_unknown && std::none_of(terms.begin(), terms.end(), [&profiled_word](const ProfiledTerm& term)
+			{ return term.word == profiled_word; }))
+		{
+			terms.push_back({ profiled_word, 0 });
+		}
+	}
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::SortUniqueTermIds(std::pmr::vector<int>& term_ids)
+{
+	std::sort(term_ids.begin(), term_ids.end());
+	term_ids.erase(std::unique(term_ids.begin(), term_ids.end()), term_ids.end());
+}
+
+template <typename Traits>
+typename BasicSearchServer<Traits>::CompiledQuery BasicSearchServer<Traits>::CompileQuery(const std::string_view text, std::pmr::memory_resource* resource) const
+{
+	Query query = ParseQuery(text, resource);
+	SortUniqueTermIds(query.plus_term_ids);
+	SortUniqueTermIds(query.minus_term_ids);
+	return { std::move(query.plus_term_ids), std::move(query.minus_term_ids) };
+}
+
+template <typename Traits>
+PlannedTerm BasicSearchServer<Traits>::PlanTerm(int term_id) const
+{
+	const size_t document_freq = term_postings_[term_id].size();
+	return { term_id_to_word_[term_id], term_id, document_freq, std::log(GetDocumentCount() * 1.0 / document_freq) };
+}
+
+template <typename Traits>
+bool BasicSearchServer<Traits>::IsDenseScoringWorthwhile(const QueryPlan& plan) const
+{
+	return document_table_.GetCapacity() <= EstimatePostings(plan) * DENSE_SCORING_MAX_SPARSITY;
+}
+
+template <typename Traits>
+QueryPlan BasicSearchServer<Traits>::PlanQuery(Query query, std::pmr::memory_resource* resource) const
+{
+	QueryPlan plan(resource);
+
+	SortUniqueTermIds(query.minus_term_ids);
+	for (const int term_id : query.minus_term_ids)
+	{
+		const PostingList<Ordinal, Score>& postings = term_postings_[term_id];
+		if (postings.empty())
+		{
+			continue;
+		}
+		plan.minus_terms.push_back(PlanTerm(term_id));
+		for (const auto [document_id, _] : postings)
 		{
-			if (query_word.is_minus)
+			if (!plan.excluded_documents.Test(document_id))
 			{
-				result.minus_words.push_back(query_word.data);
+				plan.excluded_documents.Set(document_id);
+				++plan.excluded_document_count;
 			}
-			else
+		}
+	}
+
+	// Повторы слова в запросе учитываются только в его весе при сокращении длинного запроса
+	std::sort(query.plus_term_ids.begin(), query.plus_term_ids.end());
+	std::pmr::vector<double> term_weights(resource);
+	for (auto it = query.plus_term_ids.begin(); it != query.plus_term_ids.end();)
+	{
+		const int term_id = *it;
+		const auto next = std::find_if(it, query.plus_term_ids.end(), [term_id](int other_term_id)
+			{ return other_term_id != term_id; });
+		const size_t query_freq = next - it;
+		it = next;
+		if (term_postings_[term_id].empty())
+		{
+			continue;
+		}
+		const PlannedTerm term = PlanTerm(term_id);
+		if (term.inverse_document_freq == 0.0)
+		{
+			plan.zero_weight_terms.push_back(term);
+		}
+		else
+		{
+			plan.plus_terms.push_back(term);
+			term_weights.push_back(query_freq * term.inverse_document_freq);
+		}
+	}
+	OrderPlusTerms(plan, term_weights);
+
+	return plan;
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::OrderPlusTerms(QueryPlan& plan, const std::pmr::vector<double>& term_weights) const
+{
+	const size_t max_terms = long_query_options_.max_terms;
+	if (max_terms > 0 && plan.plus_terms.size() + plan.zero_weight_terms.size() > max_terms)
+	{
+		std::pmr::memory_resource* const resource = plan.plus_terms.get_allocator().resource();
+		plan.zero_weight_terms.clear();
+
+		std::pmr::vector<size_t> kept_terms(resource);
+		for (size_t i = 0; i < plan.plus_terms.size(); ++i)
+		{
+			if (plan.plus_terms[i].inverse_document_freq >= long_query_options_.min_inverse_document_freq)
 			{
-				result.plus_words.push_back(query_word.data);
+				kept_terms.push_back(i);
 			}
 		}
+		if (kept_terms.size() > max_terms)
+		{
+			std::nth_element(kept_terms.begin(), kept_terms.begin() + max_terms, kept_terms.end(), [&plan, &term_weights](size_t lhs, size_t rhs)
+				{
+					return term_weights[lhs] > term_weights[rhs]
+						|| (term_weights[lhs] == term_weights[rhs] && plan.plus_terms[lhs].term_id < plan.plus_terms[rhs].term_id);
+				});
+			kept_terms.resize(max_terms);
+			std::sort(kept_terms.begin(), kept_terms.end());
+		}
+
+		std::pmr::vector<PlannedTerm> plus_terms(resource);
+		plus_terms.reserve(kept_terms.size());
+		for (const size_t i : kept_terms)
+		{
+			plus_terms.push_back(plan.plus_terms[i]);
+		}
+		plan.plus_terms.swap(plus_terms);
 	}
-	return result;
+
+	std::stable_sort(plan.plus_terms.begin(), plan.plus_terms.end(), [](const PlannedTerm& lhs, const PlannedTerm& rhs)
+		{ return lhs.document_freq < rhs.document_freq; });
+}
+
+template <typename Traits>
+bool BasicSearchServer<Traits>::IsRankedBefore(const Document& lhs, const Document& rhs)
+{
+	if (std::abs(lhs.relevance - rhs.relevance) >= Traits::PRECISION)
+	{
+		return lhs.relevance > rhs.relevance;
+	}
+	if (lhs.rating != rhs.rating)
+	{
+		return lhs.rating > rhs.rating;
+	}
+	return lhs.id < rhs.id;
+}
+
+template <typename Traits>
+void BasicSearchServer<Traits>::SelectPageDocuments(std::vector<Document>& matched_documents, const std::optional<Document>& last_document, size_t page_size)
+{
+	// Куча строится на месте в начале вектора; на её вершине худший из отобранных
+	auto page_end = matched_documents.begin();
+	for (auto it = matched_documents.begin(); it != matched_documents.end(); ++it)
+	{
+		if (last_document && !IsRankedBefore(*last_document, *it))
+		{
+			continue;
+		}
+		if (static_cast<size_t>(page_end - matched_documents.begin()) < page_size)
+		{
+			*page_end++ = *it;
+			std::push_heap(matched_documents.begin(), page_end, IsRankedBefore);
+		}
+		else if (IsRankedBefore(*it, matched_documents.front()))
+		{
+			std::pop_heap(matched_documents.begin(), page_end, IsRankedBefore);
+			*(page_end - 1) = *it;
+			std::push_heap(matched_documents.begin(), page_end, IsRankedBefore);
+		}
+	}
+	matched_documents.erase(page_end, matched_documents.end());
+	std::sort_heap(matched_documents.begin(), matched_documents.end(), IsRankedBefore);
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view word) const
+template <typename Traits>
+void BasicSearchServer<Traits>::SelectTopDocuments(std::vector<Document>& matched_documents, size_t count)
 {
-	return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
-}
\ No newline at end of file
+	if (matched_documents.size() > count)
+	{
+		std::partial_sort(matched_documents.begin(), matched_documents.begin() + count, matched_documents.end(), IsRankedBefore);
+		matched_documents.resize(count);
+	}
+	else
+	{
+		std::sort(matched_documents.begin(), matched_documents.end(), IsRankedBefore);
+	}
+}
+
+template class BasicSearchServer<DefaultSearchTraits>;
+template class BasicSearchServer<CompactSearchTraits>;
\ No newline at end of file
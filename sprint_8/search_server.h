@@ -6,32 +6,158 @@
 #include <sstream>
 #include <list>
 #include <map>
-#include <deque>
+#include <memory>
 #include <algorithm>
 #include <cmath>
 #include <numeric>
 #include <utility>
 #include <future>
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <atomic>
 #include <functional>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
 #include <stdexcept>
 #include <execution>
+#include <unordered_map>
 #include <unordered_set>
 #include "string_processing.h"
 #include "document.h"
+#include "document_bitmap.h"
+#include "document_filter.h"
+#include "document_table.h"
+#include "execution_planner.h"
+#include "forward_index.h"
+#include "impact_index.h"
+#include "min_hash_index.h"
+#include "mutation_stream.h"
+#include "posting_list.h"
+#include "query_arena.h"
+#include "query_plan.h"
+#include "query_profile.h"
+#include "score_kernels.h"
+#include "shared_vocabulary.h"
+#include "standing_query_index.h"
+#include "term_dictionary.h"
+#include "term_trie.h"
 #include "concurrent_map.h"
+#include "write_ahead_log.h"
 
 using namespace std::string_literals;
-const double precision = 1e-10;
-const int MAX_RESULT_DOCUMENT_COUNT = 5;
+constexpr double precision = 1e-10;
+constexpr int MAX_RESULT_DOCUMENT_COUNT = 5;
 
-class SearchServer
+// Запрос "кот*" раскрывается во все слова индекса с префиксом "кот",
+// "~кот" — во все слова на расстоянии не больше max_edit_distance. С общим словарём
+// max_expansions ограничивает раскрытие по всему общему словарю.
+struct TermExpansionOptions
+{
+	size_t max_expansions = 64;
+	int max_edit_distance = 1;
+};
+
+// Поиск по индексу вкладов обходит сегменты всех слов запроса от больших вкладов
+// к меньшим и останавливается, когда первые MAX_RESULT_DOCUMENT_COUNT документов
+// уже не могут измениться. С ненулевым postings_budget обход прерывается после
+// стольких документов, и результат становится приближённым.
+struct ImpactSearchOptions
+{
+	bool enabled = false;
+	size_t postings_budget = 0;
+};
+
+// Запрос, в котором больше max_terms плюс-слов, сокращается: слова с нулевым IDF и IDF
+// ниже min_inverse_document_freq отбрасываются, а из остальных остаются max_terms слов
+// с наибольшим весом — числом вхождений слова в запрос, умноженным на IDF. Результат
+// такого запроса приближённый. Нулевой max_terms отключает сокращение.
+struct LongQueryOptions
+{
+	size_t max_terms = 0;
+	double min_inverse_document_freq = 0.0;
+};
+
+// Частым считается слово, которое встречается не меньше чем в min_document_count
+// документах и не меньше чем в доле min_document_fraction всех документов. BITMAP
+// хранит его список в битовом представлении с квантованными частотами, DROP убирает
+// слово из индекса и из запросов так же, как стоп-слово. Слово снова становится
+// обычным, когда число его документов падает ниже половины порога.
+enum class HighFrequencyTermMode
+{
+	KEEP,
+	BITMAP,
+	DROP,
+};
+
+struct HighFrequencyTermOptions
+{
+	HighFrequencyTermMode mode = HighFrequencyTermMode::KEEP;
+	double min_document_fraction = 0.1;
+	size_t min_document_count = 1000;
+};
+
+struct HighFrequencyTerm
+{
+	std::string_view word;
+	size_t document_freq = 0;
+	// Память списка в виде массивов и в нынешнем виде
+	size_t array_bytes = 0;
+	size_t bytes = 0;
+};
+
+struct HighFrequencyTermReport
+{
+	std::vector<HighFrequencyTerm> terms;
+	std::ptrdiff_t saved_bytes = 0;
+};
+
+// Позиция последнего документа предыдущей страницы выдачи
+template <typename DocumentId, typename Relevance>
+struct BasicSearchCursor
+{
+	Relevance relevance = 0;
+	int rating = 0;
+	DocumentId document_id = 0;
+};
+
+using SearchCursor = BasicSearchCursor<int, double>;
+
+// Числовые типы сервера: id документов, релевантность и частоты слов в индексах,
+// а также число документов в выдаче и точность сравнения релевантностей
+struct DefaultSearchTraits
+{
+	using DocumentId = int;
+	using Score = double;
+	static constexpr size_t MAX_RESULT_DOCUMENT_COUNT = ::MAX_RESULT_DOCUMENT_COUNT;
+	static constexpr Score PRECISION = precision;
+};
+
+// Вдвое меньше памяти на частоты в индексах и на документы выдачи
+struct CompactSearchTraits
+{
+	using DocumentId = uint32_t;
+	using Score = float;
+	static constexpr size_t MAX_RESULT_DOCUMENT_COUNT = ::MAX_RESULT_DOCUMENT_COUNT;
+	static constexpr Score PRECISION = 1e-6f;
+};
+
+// Определения членов находятся в search_server.cpp и инстанцированы
+// для DefaultSearchTraits и CompactSearchTraits
+template <typename Traits>
+class BasicSearchServer
 {
 public:
-	SearchServer();
+	using DocumentId = typename Traits::DocumentId;
+	using Score = typename Traits::Score;
+	using Document = BasicDocument<DocumentId, Score>;
+	using SearchCursor = BasicSearchCursor<DocumentId, Score>;
+
+	BasicSearchServer();
 
 	template <typename StringContainer>
-	SearchServer(const StringContainer& stop_words)
+	BasicSearchServer(const StringContainer& stop_words)
 		: stop_words_(MakeUniqueNonEmptyStrings(stop_words))
 	{
 		if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord))
@@ -40,10 +166,47 @@ public:
 		}
 	}
 
-	explicit SearchServer(const std::string& stop_words_text);
-	explicit SearchServer(const std::string_view stop_words_text);
+	explicit BasicSearchServer(const std::string& stop_words_text);
+	explicit BasicSearchServer(const std::string_view stop_words_text);
+
+	void AddDocument(DocumentId document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+	// Если передан word_storage, новые слова не копируются: сервер хранит представления
+	// прямо в нём и держит word_storage живым до своего уничтожения
+	void AddTokenizedDocument(DocumentId document_id, const std::vector<std::string_view>& words, DocumentStatus status, const std::vector<int>& ratings,
+		const std::shared_ptr<const void>& word_storage = nullptr);
+
+	// Воспроизводит записи существующего журнала и дальше записывает в него каждое
+	// добавление и удаление документа; возвращает число воспроизведённых записей
+	size_t OpenWriteAheadLog(const std::string& path, const WriteAheadLogOptions& options = {});
+	void SyncWriteAheadLog();
+	// Сбрасывает журнал на диск, передаёт сервер save_snapshot и после успешного
+	// сохранения усекает журнал
+	void CheckpointWriteAheadLog(const std::function<void(const BasicSearchServer&)>& save_snapshot);
+	WriteAheadLogStats GetWriteAheadLogStats() const;
+
+	// Дальше каждое добавление и удаление документа публикуется для реплик (см. ReadReplica).
+	// Открывается до добавления первого документа, в том числе до OpenWriteAheadLog
+	void OpenMutationPublisher(const std::string& socket_path, const MutationPublisherOptions& options = {});
+	// Номер последнего опубликованного изменения; реплика, применившая его, содержит
+	// все документы сервера. 0, если издатель не открыт или изменений не было
+	uint64_t GetMutationSequence() const;
+	MutationPublisherStats GetMutationPublisherStats() const;
 
-	void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+	void SetTermExpansionOptions(const TermExpansionOptions& options);
+
+	// Слова документов хранятся в общем словаре, а не в сервере; у сервера остаются свои
+	// списки документов и отображение слов в них. Задаётся до добавления первого документа
+	void SetSharedVocabulary(std::shared_ptr<SharedVocabulary> vocabulary);
+
+	// Индекс вкладов сбрасывается при любом добавлении или удалении документа
+	void BuildImpactIndex();
+	void SetImpactSearchOptions(const ImpactSearchOptions& options);
+	void SetLongQueryOptions(const LongQueryOptions& options);
+
+	// Пересматривает все слова по новым настройкам; дальше слово проверяется, когда
+	// меняется число его документов
+	void SetHighFrequencyTermOptions(const HighFrequencyTermOptions& options);
+	HighFrequencyTermReport GetHighFrequencyTermReport() const;
 
 	template <typename DocumentPredicate>
 	std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const;
@@ -52,6 +215,10 @@ public:
 	template <typename DocumentPredicate>
 	std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const;
 
+	std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, const DocumentFilter& filter) const;
+	std::vector<Document> FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, const DocumentFilter& filter) const;
+	std::vector<Document> FindTopDocuments(const std::string_view raw_query, const DocumentFilter& filter) const;
+
 	std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentStatus status) const;
 	std::vector<Document> FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, DocumentStatus status) const;
 	std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus status) const;
@@ -60,245 +227,839 @@ public:
 	std::vector<Document> FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query) const;
 	std::vector<Document> FindTopDocuments(const std::string_view raw_query) const;
 
+	// Выполняют запрос так же, как перегрузки без profile, и записывают в profile его
+	// разбор, объём работы и время этапов
+	std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, const DocumentFilter& filter, QueryProfile& profile) const;
+	std::vector<Document> FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, const DocumentFilter& filter, QueryProfile& profile) const;
+	std::vector<Document> FindTopDocuments(const std::string_view raw_query, const DocumentFilter& filter, QueryProfile& profile) const;
+	std::vector<Document> FindTopDocuments(const std::string_view raw_query, QueryProfile& profile) const;
+
+	// Возвращает до page_size документов, следующих в порядке ранжирования за after
+	template <typename DocumentPredicate>
+	std::vector<Document> FindDocumentsPage(const std::string_view raw_query, const std::optional<SearchCursor>& after, size_t page_size, DocumentPredicate document_predicate) const;
+	std::vector<Document> FindDocumentsPage(const std::string_view raw_query, const std::optional<SearchCursor>& after, size_t page_size, const DocumentFilter& filter) const;
+	std::vector<Document> FindDocumentsPage(const std::string_view raw_query, const std::optional<SearchCursor>& after, size_t page_size) const;
+
+	// Результаты те же, что у FindTopDocuments для каждого запроса по отдельности. Одинаковые
+	// после разбора запросы выполняются один раз, а список документов каждого слова
+	// просматривается один раз на весь пакет и раздаёт вклады всем запросам с этим словом
+	std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string>& raw_queries, const DocumentFilter& filter) const;
+	std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string>& raw_queries) const;
+
+	QueryPlan ExplainQuery(const std::string_view raw_query) const;
+
+	// Ищет документы, похожие на document_id: запросом служат слова документа с весом
+	// tf * idf, сокращённые по LongQueryOptions. Сам документ в результат не входит;
+	// бросает std::out_of_range, если документа нет
+	std::vector<Document> FindSimilar(DocumentId document_id, const DocumentFilter& filter) const;
+	std::vector<Document> FindSimilar(DocumentId document_id) const;
+
+	// Сохранённые запросы проверяются на каждом добавленном документе. Слова с * и ~
+	// в них не допускаются: их раскрытие зависит от словаря на момент проверки
+	void AddStandingQuery(int query_id, const std::string_view raw_query);
+	bool RemoveStandingQuery(int query_id);
+	// Вызывается после добавления документа, которому подходит хотя бы один сохранённый запрос
+	void SetStandingQueryCallback(std::function<void(DocumentId, const std::vector<StandingQueryMatch>&)> callback);
+	// Сохранённые запросы, которым подходит документ, в незаданном порядке с релевантностью,
+	// которую дал бы FindTopDocuments; бросает std::out_of_range, если документа нет
+	std::vector<StandingQueryMatch> MatchStandingQueries(DocumentId document_id) const;
+
+	// Перегрузки FindTopDocuments без политики выполнения выбирают её сами по оценке объёма работы
+	void SetParallelThreshold(size_t parallel_threshold);
+	ExecutionStats GetExecutionStats() const;
+
 	int GetDocumentCount() const;
-	const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+	// Представление действительно до следующего добавления или удаления документа
+	WordFrequencies<Score> GetWordFrequencies(DocumentId document_id) const;
+
+	// Номера удалённых документов по умолчанию не переиспользуются, пока есть новые: иначе
+	// каждое добавление сдвигает хвосты списков своих слов. Переиспользование держит
+	// таблицу документов и плотный аккумулятор запроса компактными ценой медленных добавлений
+	void SetOrdinalReuse(bool reuse);
+
+	void RemoveDocument(DocumentId document_id);
+	void RemoveDocument(std::execution::parallel_policy policy, DocumentId document_id);
+	void RemoveDocument(std::execution::sequenced_policy policy, DocumentId document_id);
+
+	// Удаление пакетом: вхождения группируются по словам, и список каждого затронутого
+	// слова обновляется один раз; с политикой par списки разных слов обновляются
+	// параллельно. Отсутствующие id пропускаются; возвращает число удалённых документов
+	size_t RemoveDocuments(const std::vector<DocumentId>& document_ids);
+	size_t RemoveDocuments(std::execution::sequenced_policy policy, const std::vector<DocumentId>& document_ids);
+	size_t RemoveDocuments(std::execution::parallel_policy policy, const std::vector<DocumentId>& document_ids);
+
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query, DocumentId document_id) const;
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentId document_id) const;
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::execution::parallel_policy policy, const std::string_view raw_query, DocumentId document_id) const;
+
+	std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(const std::string_view raw_query, const std::vector<DocumentId>& document_ids) const;
 
-	void RemoveDocument(int document_id);
-	void RemoveDocument(std::execution::parallel_policy policy, int document_id);
-	void RemoveDocument(std::execution::sequenced_policy policy, int document_id);
+	// MinHash-сигнатуры считаются только после включения; сигнатуры уже добавленных
+	// документов строятся сразу. Без включения поиск дубликатов бросает std::invalid_argument
+	void EnableNearDuplicateDetection();
+	std::vector<DocumentId> FindNearDuplicates(DocumentId document_id, double threshold) const;
 
-	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query, int document_id) const;
-	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::execution::sequenced_policy policy, const std::string_view raw_query, int document_id) const;
-	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::execution::parallel_policy policy, const std::string_view raw_query, int document_id) const;
+	// Проходит документы по возрастанию id и удаляет каждый, похожий на уже оставленный документ
+	// с меньшим id; документ, похожий только на удалённые, остаётся. Возвращает id удалённых
+	std::vector<DocumentId> RemoveDuplicates(double threshold);
+	std::vector<DocumentId> RemoveDuplicates(std::execution::sequenced_policy policy, double threshold);
+	std::vector<DocumentId> RemoveDuplicates(std::execution::parallel_policy policy, double threshold);
 
-	std::set<int>::const_iterator begin() const;
-	std::set<int>::const_iterator end() const;
+	typename DocumentTable<DocumentId>::IdIterator begin() const;
+	typename DocumentTable<DocumentId>::IdIterator end() const;
 
 private:
-	struct DocumentData
-	{
-		int rating;
-		DocumentStatus status;
-		std::unordered_set<std::string_view> words;
-	};
+	// Внутри сервера документы адресуются плотными порядковыми номерами из document_table_;
+	// внешние id появляются только на входе и в результатах
+	using Ordinal = typename DocumentTable<DocumentId>::Ordinal;
 	struct QueryWord
 	{
 		std::string_view data;
 		bool is_minus;
 		bool is_stop;
+		bool is_prefix;
+		bool is_fuzzy;
 	};
+	// Слова запроса разрешаются в id термов один раз при разборе; слов, которых нет
+	// в индексе, в запросе не остаётся
 	struct Query
 	{
-		std::deque<std::string_view> plus_words;
-		std::deque<std::string_view> minus_words;
+		explicit Query(std::pmr::memory_resource* resource)
+			: plus_term_ids(resource), minus_term_ids(resource)
+		{
+		}
+
+		std::pmr::vector<int> plus_term_ids;
+		std::pmr::vector<int> minus_term_ids;
+	};
+	struct CompiledQuery
+	{
+		std::pmr::vector<int> plus_term_ids;
+		std::pmr::vector<int> minus_term_ids;
 	};
 
 	const std::set<std::string, std::less<>> stop_words_;
 
 	std::unordered_set<std::string> unique_words;
-	std::string_view AddUniqueWord(const std::string& word);
+	std::vector<std::shared_ptr<const void>> word_storages_;
+
+	TermDictionary term_dictionary_;
+	std::vector<std::string_view> term_id_to_word_;
+	int AddTerm(const std::string_view word, bool copy_word);
+
+	// С общим словарём префиксное дерево не заполняется: раскрытия ищутся в общем
+	std::shared_ptr<SharedVocabulary> shared_vocabulary_;
+	TermTrie term_trie_;
+	TermExpansionOptions term_expansion_options_;
 
-	std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-	std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
+	// Списки документов по id терма
+	std::vector<PostingList<Ordinal, Score>> term_postings_;
+	ForwardIndex<Score> forward_index_;
 
-	std::map<int, DocumentData> documents_;
-	std::set<int> document_ids_;
+	DocumentTable<DocumentId> document_table_;
 
-	bool IsStopWord(const std::string& word) const;
+	ExecutionPlanner execution_planner_;
+	ImpactIndex impact_index_;
+	ImpactSearchOptions impact_search_options_;
+	LongQueryOptions long_query_options_;
+	StandingQueryIndex standing_query_index_;
+	std::function<void(DocumentId, const std::vector<StandingQueryMatch>&)> standing_query_callback_;
+	std::vector<StandingQueryMatch> PercolateOrdinal(Ordinal ordinal) const;
+	bool is_near_duplicate_detection_enabled_ = false;
+	MinHashIndex min_hash_index_;
+	std::unique_ptr<WriteAheadLog> write_ahead_log_;
+	std::unique_ptr<MutationPublisher> mutation_publisher_;
 
-	static bool IsValidWord(const std::string& word);
+	HighFrequencyTermOptions high_frequency_term_options_;
+	std::set<int> high_frequency_term_ids_;
+	// Число документов термов, исключённых в режиме DROP; их списки пусты
+	std::map<int, size_t> dropped_term_freqs_;
+	size_t GetHighFrequencyThreshold() const;
+	void UpdateHighFrequencyTerm(int term_id);
+	// Восстанавливает точный список терма по прямому индексу
+	void RestorePostings(int term_id);
+	std::vector<int> CollectHighFrequencyTerms(Ordinal ordinal) const;
+	bool IsDroppedTerm(int term_id) const;
+	// Есть ли у терма документы; термы из словаря не удаляются
+	bool HasDocuments(int term_id) const;
+	// Слово с документами, которое не отброшено как частое и может войти в раскрытие запроса
+	bool IsExpandableTerm(int term_id) const;
 
-	std::deque<std::string_view> SplitIntoWordsNoStop(const std::string_view text) const;
+	bool MatchesFilter(const DocumentFilter& filter, Ordinal ordinal) const;
+	void CheckNearDuplicateDetection() const;
+	void RemoveOrdinal(Ordinal ordinal);
+	template <typename ExecutionPolicy>
+	size_t RemoveDocumentBatch(ExecutionPolicy policy, const std::vector<DocumentId>& document_ids);
+	template <typename ExecutionPolicy>
+	std::vector<DocumentId> RemoveDuplicateGroups(ExecutionPolicy policy, double threshold);
 
-	Query ParseQuery(const std::string_view text) const;
+	bool IsStopWord(const std::string_view word) const;
+
+	static bool IsValidWord(const std::string_view word);
+
+	std::vector<std::string_view> FilterWordsNoStop(const std::vector<std::string_view>& words) const;
+
+	Query ParseQuery(const std::string_view text, std::pmr::memory_resource* resource) const;
 	QueryWord ParseQueryWord(const std::string_view text) const;
+	std::vector<int> ExpandQueryWord(const QueryWord& query_word) const;
+	CompiledQuery CompileQuery(const std::string_view text, std::pmr::memory_resource* resource) const;
+	static void SortUniqueTermIds(std::pmr::vector<int>& term_ids);
+
+	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchCompiledQuery(const CompiledQuery& query, DocumentId document_id) const;
+
+	QueryPlan PlanQuery(Query query, std::pmr::memory_resource* resource) const;
+	// Сокращает длинный запрос по long_query_options_ и упорядочивает плюс-слова по возрастанию
+	// document_freq; term_weights — веса плюс-слов в порядке plan.plus_terms
+	void OrderPlusTerms(QueryPlan& plan, const std::pmr::vector<double>& term_weights) const;
+	PlannedTerm PlanTerm(int term_id) const;
 
 	static int ComputeAverageRating(const std::vector<int>& ratings);
-	double ComputeWordInverseDocumentFreq(const std::string_view word) const;
 
 	template <typename DocumentPredicate>
-	std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
-	template <typename DocumentPredicate>
-	std::vector<Document> FindAllDocuments(std::execution::sequenced_policy policy, const Query& query, DocumentPredicate document_predicate) const;
-	template <typename DocumentPredicate>
-	std::vector<Document> FindAllDocuments(std::execution::parallel_policy policy, const Query& query, DocumentPredicate document_predicate) const;
+	auto MakeDocumentMatcher(DocumentPredicate& document_predicate) const;
+
+	static size_t EstimatePostings(const QueryPlan& plan);
+
+	template <typename DocumentMatcher>
+	std::vector<Document> FindTopMatchedDocuments(const std::string_view raw_query, DocumentMatcher document_matcher) const;
+	// Способ выполнения выбирается так же, как для перегрузок без политики
+	template <typename DocumentMatcher>
+	std::vector<Document> FindTopPlannedDocuments(const QueryPlan& plan, DocumentMatcher document_matcher, std::pmr::memory_resource* resource) const;
+	template <typename DocumentMatcher>
+	std::vector<Document> FindTopMatchedDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentMatcher document_matcher) const;
+	template <typename DocumentMatcher>
+	std::vector<Document> FindTopMatchedDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, DocumentMatcher document_matcher) const;
+	// Режим выбирает планировщик, если forced_mode пуст
+	template <typename DocumentMatcher>
+	std::vector<Document> ProfileTopMatchedDocuments(std::optional<ExecutionMode> forced_mode, const std::string_view raw_query, DocumentMatcher document_matcher, QueryProfile& profile) const;
+	// Добавляет в профиль слова запроса, которым не нашлось ни одного документа, с нулевым числом вхождений
+	void AddUnknownProfiledTerms(const std::string_view raw_query, QueryProfile& profile) const;
+
+	// Временные данные запроса выделяются из resource; из глобальной кучи — только возвращаемый вектор.
+	// Если передан profile, в него записываются счётчики обхода
+	template <typename DocumentMatcher>
+	std::vector<Document> FindAllDocuments(const QueryPlan& plan, DocumentMatcher document_matcher, std::pmr::memory_resource* resource) const;
+	template <typename DocumentMatcher>
+	std::vector<Document> FindAllDocuments(std::execution::sequenced_policy policy, const QueryPlan& plan, DocumentMatcher document_matcher, std::pmr::memory_resource* resource,
+		QueryProfile* profile = nullptr) const;
+	// Обход делится на parallelism задач
+	template <typename DocumentMatcher>
+	std::vector<Document> FindAllDocuments(std::execution::parallel_policy policy, const QueryPlan& plan, DocumentMatcher document_matcher, size_t parallelism,
+		std::pmr::memory_resource* resource, QueryProfile* profile = nullptr) const;
+	static constexpr size_t PARALLEL_ACCUMULATOR_BUCKET_COUNT = 100;
+
+	// Плотный аккумулятор по всем id выгоднее дерева, когда id не сильно разрежены
+	// относительно числа просматриваемых вхождений
+	static constexpr size_t DENSE_SCORING_MAX_SPARSITY = 16;
+	static constexpr size_t DENSE_SCAN_BLOCK_SIZE = 1024;
+	bool IsDenseScoringWorthwhile(const QueryPlan& plan) const;
+	template <typename DocumentMatcher>
+	std::vector<Document> FindAllDocumentsDense(const QueryPlan& plan, DocumentMatcher document_matcher, std::pmr::memory_resource* resource, QueryProfile* profile = nullptr) const;
+
+	// Пакет обходит id блоками, чтобы аккумуляторы всех запросов блока занимали
+	// не больше BATCH_ACCUMULATOR_SIZE элементов
+	static constexpr size_t BATCH_ACCUMULATOR_SIZE = 1 << 18;
+	static constexpr size_t MIN_BATCH_BLOCK_SIZE = 64;
+
+	template <typename DocumentMatcher>
+	std::vector<Document> FindMatchedDocumentsPage(const std::string_view raw_query, const std::optional<SearchCursor>& after, size_t page_size, DocumentMatcher document_matcher) const;
+
+	bool IsImpactSearchActive() const;
+	template <typename DocumentMatcher>
+	std::vector<Document> FindTopDocumentsByImpact(const QueryPlan& plan, DocumentMatcher document_matcher, std::pmr::memory_resource* resource, QueryProfile* profile = nullptr,
+		size_t count = Traits::MAX_RESULT_DOCUMENT_COUNT) const;
+
+	static bool IsRankedBefore(const Document& lhs, const Document& rhs);
+	static void SelectTopDocuments(std::vector<Document>& matched_documents, size_t count = Traits::MAX_RESULT_DOCUMENT_COUNT);
+	// Оставляет page_size лучших документов, идущих после last_document, через кучу
+	// размера страницы, не сортируя остальные совпадения
+	static void SelectPageDocuments(std::vector<Document>& matched_documents, const std::optional<Document>& last_document, size_t page_size);
 };
 
+template <typename Traits>
+inline bool BasicSearchServer<Traits>::MatchesFilter(const DocumentFilter& filter, Ordinal ordinal) const
+{
+	if (filter.status && document_table_.GetStatus(ordinal) != *filter.status)
+	{
+		return false;
+	}
+	const int rating = document_table_.GetRating(ordinal);
+	return rating >= filter.min_rating && rating <= filter.max_rating;
+}
+
+template <typename Traits>
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const
+auto BasicSearchServer<Traits>::MakeDocumentMatcher(DocumentPredicate& document_predicate) const
 {
-	Query query = ParseQuery(raw_query);
+	return [this, &document_predicate](Ordinal ordinal)
+	{
+		return document_predicate(document_table_.GetId(ordinal), document_table_.GetStatus(ordinal), document_table_.GetRating(ordinal));
+	};
+}
 
-	std::sort(query.plus_words.begin(), query.plus_words.end());
-	auto last_plus = std::unique(query.plus_words.begin(), query.plus_words.end());
-	query.plus_words.erase(last_plus, query.plus_words.end());
+template <typename Traits>
+template <typename DocumentPredicate>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const
+{
+	return FindTopMatchedDocuments(policy, raw_query, MakeDocumentMatcher(document_predicate));
+}
 
-	std::sort(query.minus_words.begin(), query.minus_words.end());
-	auto last_minus = std::unique(query.minus_words.begin(), query.minus_words.end());
-	query.minus_words.erase(last_minus, query.minus_words.end());
+template <typename Traits>
+template <typename DocumentPredicate>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const
+{
+	return FindTopMatchedDocuments(policy, raw_query, MakeDocumentMatcher(document_predicate));
+}
 
-	auto matched_documents = FindAllDocuments(query, document_predicate);
+template <typename Traits>
+template <typename DocumentPredicate>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const
+{
+	return FindTopMatchedDocuments(raw_query, MakeDocumentMatcher(document_predicate));
+}
 
-	sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs)
-		{
-			if (std::abs(lhs.relevance - rhs.relevance) < precision) {
-				return lhs.rating > rhs.rating;
-			}
-			else {
-				return lhs.relevance > rhs.relevance;
-			} });
+template <typename Traits>
+template <typename DocumentMatcher>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopMatchedDocuments(const std::string_view raw_query, DocumentMatcher document_matcher) const
+{
+	const QueryArenaScope arena;
+	const QueryPlan plan = PlanQuery(ParseQuery(raw_query, arena.Resource()), arena.Resource());
+	return FindTopPlannedDocuments(plan, document_matcher, arena.Resource());
+}
 
-	if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT)
+template <typename Traits>
+template <typename DocumentMatcher>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopPlannedDocuments(const QueryPlan& plan, DocumentMatcher document_matcher, std::pmr::memory_resource* resource) const
+{
+	if (IsImpactSearchActive())
 	{
-		matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+		return FindTopDocumentsByImpact(plan, document_matcher, resource);
 	}
 
+	const ExecutionDecision decision = execution_planner_.Choose(EstimatePostings(plan));
+	auto matched_documents = decision.mode == ExecutionMode::PARALLEL
+		? FindAllDocuments(std::execution::par, plan, document_matcher, decision.parallelism, resource)
+		: FindAllDocuments(std::execution::seq, plan, document_matcher, resource);
+	SelectTopDocuments(matched_documents);
+
 	return matched_documents;
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const
+template <typename Traits>
+template <typename DocumentMatcher>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopMatchedDocuments(std::execution::sequenced_policy, const std::string_view raw_query, DocumentMatcher document_matcher) const
 {
-	return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+	const QueryArenaScope arena;
+	const QueryPlan plan = PlanQuery(ParseQuery(raw_query, arena.Resource()), arena.Resource());
+	if (IsImpactSearchActive())
+	{
+		return FindTopDocumentsByImpact(plan, document_matcher, arena.Resource());
+	}
+
+	auto matched_documents = FindAllDocuments(plan, document_matcher, arena.Resource());
+	SelectTopDocuments(matched_documents);
+
+	return matched_documents;
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const
+template <typename Traits>
+template <typename DocumentMatcher>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopMatchedDocuments(std::execution::parallel_policy, const std::string_view raw_query, DocumentMatcher document_matcher) const
 {
-	Query query = ParseQuery(raw_query);
-
-	auto sort_plus = std::async([&query]
-		{ std::sort(query.plus_words.begin(), query.plus_words.end()); });
-	auto sort_minus = std::async([&query]
-		{ std::sort(query.minus_words.begin(), query.minus_words.end()); });
+	const QueryArenaScope arena;
+	const QueryPlan plan = PlanQuery(ParseQuery(raw_query, arena.Resource()), arena.Resource());
+	if (IsImpactSearchActive())
+	{
+		return FindTopDocumentsByImpact(plan, document_matcher, arena.Resource());
+	}
 
-	sort_plus.get();
+	auto matched_documents = FindAllDocuments(std::execution::par, plan, document_matcher, execution_planner_.GetMaxParallelism(), arena.Resource());
+	SelectTopDocuments(matched_documents);
 
-	auto last_plus = std::unique(query.plus_words.begin(), query.plus_words.end());
-	query.plus_words.erase(last_plus, query.plus_words.end());
+	return matched_documents;
+}
 
-	sort_minus.get();
+template <typename Traits>
+template <typename DocumentMatcher>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::ProfileTopMatchedDocuments(std::optional<ExecutionMode> forced_mode, const std::string_view raw_query, DocumentMatcher document_matcher, QueryProfile& profile) const
+{
+	using Clock = std::chrono::steady_clock;
 
-	auto last_minus = std::unique(query.minus_words.begin(), query.minus_words.end());
-	query.minus_words.erase(last_minus, query.minus_words.end());
+	profile = {};
+	auto phase_start = Clock::now();
+	const auto finish_phase = [&phase_start](std::chrono::nanoseconds& phase_time)
+	{
+		const auto now = Clock::now();
+		phase_time = now - phase_start;
+		phase_start = now;
+	};
 
-	auto matched_documents = FindAllDocuments(std::execution::par, query, document_predicate);
+	const QueryArenaScope arena;
+	Query query = ParseQuery(raw_query, arena.Resource());
+	finish_phase(profile.parse_time);
+	const QueryPlan plan = PlanQuery(std::move(query), arena.Resource());
+	finish_phase(profile.plan_time);
 
-	sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs)
+	for (const auto* terms : { &plan.plus_terms, &plan.zero_weight_terms })
+	{
+		for (const PlannedTerm& term : *terms)
 		{
-			if (std::abs(lhs.relevance - rhs.relevance) < precision) {
-				return lhs.rating > rhs.rating;
-			}
-			else {
-				return lhs.relevance > rhs.relevance;
-			} });
+			profile.plus_terms.push_back({ std::string(term.word), term.document_freq });
+		}
+	}
+	for (const PlannedTerm& term : plan.minus_terms)
+	{
+		profile.minus_terms.push_back({ std::string(term.word), term.document_freq });
+	}
+	AddUnknownProfiledTerms(raw_query, profile);
+	profile.excluded_documents = plan.excluded_document_count;
 
-	if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT)
+	// Счётчик атомарный, потому что в параллельном выполнении предикат вызывается из многих потоков
+	std::atomic<uint64_t> predicate_calls{ 0 };
+	const auto counting_matcher = [&document_matcher, &predicate_calls](Ordinal ordinal)
 	{
-		matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+		predicate_calls.fetch_add(1, std::memory_order_relaxed);
+		return document_matcher(ordinal);
+	};
+
+	std::vector<Document> matched_documents;
+	if (IsImpactSearchActive())
+	{
+		// подсчёт и отбор лучших по вкладу идут в одной функции, и она сама замеряет обе фазы
+		profile.path = QueryExecutionPath::IMPACT;
+		matched_documents = FindTopDocumentsByImpact(plan, counting_matcher, arena.Resource(), &profile);
+		profile.predicate_calls = predicate_calls;
+		return matched_documents;
 	}
 
+	ExecutionDecision decision;
+	if (forced_mode)
+	{
+		decision.mode = *forced_mode;
+		decision.parallelism = *forced_mode == ExecutionMode::PARALLEL ? execution_planner_.GetMaxParallelism() : 1;
+	}
+	else
+	{
+		decision = execution_planner_.Choose(EstimatePostings(plan));
+	}
+	if (decision.mode == ExecutionMode::PARALLEL)
+	{
+		profile.path = QueryExecutionPath::PARALLEL;
+		matched_documents = FindAllDocuments(std::execution::par, plan, counting_matcher, decision.parallelism, arena.Resource(), &profile);
+	}
+	else
+	{
+		profile.path = IsDenseScoringWorthwhile(plan) ? QueryExecutionPath::DENSE : QueryExecutionPath::SEQUENTIAL;
+		matched_documents = FindAllDocuments(std::execution::seq, plan, counting_matcher, arena.Resource(), &profile);
+	}
+	finish_phase(profile.score_time);
+	profile.predicate_calls = predicate_calls;
+
+	SelectTopDocuments(matched_documents);
+	finish_phase(profile.select_time);
+
 	return matched_documents;
 }
 
+template <typename Traits>
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(std::execution::sequenced_policy policy, const Query& query, DocumentPredicate document_predicate) const
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindDocumentsPage(const std::string_view raw_query, const std::optional<SearchCursor>& after, size_t page_size, DocumentPredicate document_predicate) const
 {
-	std::map<int, double> document_to_relevance;
+	return FindMatchedDocumentsPage(raw_query, after, page_size, MakeDocumentMatcher(document_predicate));
+}
 
-	for (const std::string_view word : query.plus_words)
+template <typename Traits>
+template <typename DocumentMatcher>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindMatchedDocumentsPage(const std::string_view raw_query, const std::optional<SearchCursor>& after, size_t page_size, DocumentMatcher document_matcher) const
+{
+	if (page_size == 0)
 	{
-		if (word_to_document_freqs_.count(word) == 0)
-		{
-			continue;
-		}
-		const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
+		return {};
+	}
+	const QueryArenaScope arena;
+	const QueryPlan plan = PlanQuery(ParseQuery(raw_query, arena.Resource()), arena.Resource());
+	std::optional<Document> last_document;
+	if (after)
+	{
+		last_document = Document{ after->document_id, after->relevance, after->rating };
+	}
 
-		for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word))
+	if (IsImpactSearchActive())
+	{
+		// Документы предыдущих страниц тоже входят в лучшие по вкладу, поэтому выборка
+		// удваивается, пока после курсора не наберётся страница или не кончатся совпадения
+		for (size_t count = page_size;; count *= 2)
 		{
-			const auto& document_data = documents_.at(document_id);
-			if (document_predicate(document_id, document_data.status, document_data.rating))
+			auto top_documents = FindTopDocumentsByImpact(plan, document_matcher, arena.Resource(), nullptr, count);
+			const bool is_exhausted = top_documents.size() < count;
+			SelectPageDocuments(top_documents, last_document, page_size);
+			if (top_documents.size() == page_size || is_exhausted)
 			{
-				document_to_relevance[document_id] += term_freq * inverse_document_freq;
+				return top_documents;
 			}
 		}
 	}
 
-	for (const std::string_view word : query.minus_words)
+	const ExecutionDecision decision = execution_planner_.Choose(EstimatePostings(plan));
+	auto matched_documents = decision.mode == ExecutionMode::PARALLEL
+		? FindAllDocuments(std::execution::par, plan, document_matcher, decision.parallelism, arena.Resource())
+		: FindAllDocuments(std::execution::seq, plan, document_matcher, arena.Resource());
+	SelectPageDocuments(matched_documents, last_document, page_size);
+
+	return matched_documents;
+}
+
+template <typename Traits>
+template <typename DocumentMatcher>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindAllDocuments(std::execution::sequenced_policy, const QueryPlan& plan, DocumentMatcher document_matcher, std::pmr::memory_resource* resource,
+	QueryProfile* profile) const
+{
+	if (IsDenseScoringWorthwhile(plan))
+	{
+		return FindAllDocumentsDense(plan, document_matcher, resource, profile);
+	}
+
+	std::pmr::map<Ordinal, Score> document_to_relevance(resource);
+	size_t scanned_postings = 0;
+
+	for (const PlannedTerm& term : plan.plus_terms)
 	{
-		if (word_to_document_freqs_.count(word) == 0)
+		for (const auto [ordinal, term_freq] : term_postings_[term.term_id])
 		{
-			continue;
+			++scanned_postings;
+			if (!plan.excluded_documents.Test(ordinal) && document_matcher(ordinal))
+			{
+				document_to_relevance[ordinal] += term_freq * term.inverse_document_freq;
+			}
 		}
-		for (const auto [document_id, _] : word_to_document_freqs_.at(word))
+	}
+
+	for (const PlannedTerm& term : plan.zero_weight_terms)
+	{
+		for (const auto [ordinal, _] : term_postings_[term.term_id])
 		{
-			document_to_relevance.erase(document_id);
+			++scanned_postings;
+			if (!plan.excluded_documents.Test(ordinal) && document_matcher(ordinal))
+			{
+				document_to_relevance.emplace(ordinal, Score{});
+			}
 		}
 	}
 
+	if (profile)
+	{
+		profile->postings_scanned = scanned_postings;
+		profile->accumulator_size = document_to_relevance.size();
+	}
+
 	std::vector<Document> matched_documents;
-	for (const auto [document_id, relevance] : document_to_relevance)
+	matched_documents.reserve(document_to_relevance.size());
+	for (const auto [ordinal, relevance] : document_to_relevance)
 	{
-		matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+		matched_documents.push_back({ document_table_.GetId(ordinal), relevance, document_table_.GetRating(ordinal) });
 	}
 	return matched_documents;
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const
+template <typename Traits>
+template <typename DocumentMatcher>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindAllDocuments(const QueryPlan& plan, DocumentMatcher document_matcher, std::pmr::memory_resource* resource) const
 {
-	return FindAllDocuments(std::execution::seq, query, document_predicate);
+	return FindAllDocuments(std::execution::seq, plan, document_matcher, resource);
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(std::execution::parallel_policy policy, const Query& query, DocumentPredicate document_predicate) const
+template <typename Traits>
+template <typename DocumentMatcher>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindAllDocuments(std::execution::parallel_policy, const QueryPlan& plan, DocumentMatcher document_matcher, size_t parallelism,
+	std::pmr::memory_resource* resource, QueryProfile* profile) const
 {
-	ConcurrentMap<int, double> document_to_relevance(100);
-
-	std::vector<std::string> plus_words{ query.plus_words.begin(), query.plus_words.end() };
-	std::vector<std::string> minus_words{ query.minus_words.begin(), query.minus_words.end() };
+	ConcurrentMap<Ordinal, Score> document_to_relevance(PARALLEL_ACCUMULATOR_BUCKET_COUNT, resource);
+	std::atomic<uint64_t> scanned_postings{ 0 };
 
-	for_each(std::execution::par,
-		plus_words.begin(), plus_words.end(),
-		[&document_to_relevance, this, &document_predicate, &query, &minus_words](std::string_view word)
+	// Каждая из parallelism задач обходит свою часть каждого списка-массива и свою долю
+	// списков в битовом представлении, поэтому одновременно работает не больше parallelism потоков.
+	// У слов с нулевым весом inverse_document_freq равен нулю: они только добавляют документ
+	parallelism = std::max<size_t>(parallelism, 1);
+	std::pmr::vector<size_t> tasks(parallelism, resource);
+	std::iota(tasks.begin(), tasks.end(), 0);
+	std::for_each(std::execution::par,
+		tasks.begin(), tasks.end(),
+		[this, &plan, &document_to_relevance, &document_matcher, &scanned_postings, parallelism](size_t task)
 		{
-			auto contain_minus = std::any_of(std::execution::par,
-				minus_words.begin(), minus_words.end(),
-				[&word](const auto& minus_word)
-				{
-					return minus_word == word;
-				});
-
-			if (word_to_document_freqs_.count(word) && !contain_minus)
+			uint64_t task_scanned_postings = 0;
+			size_t bitmap_count = 0;
+			for (const auto* terms : { &plan.plus_terms, &plan.zero_weight_terms })
 			{
-				const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-				std::for_each(std::execution::par,
-					word_to_document_freqs_.at(std::string(word)).begin(), word_to_document_freqs_.at(std::string(word)).end(),
-					[this, &document_to_relevance, &inverse_document_freq, &document_predicate](const auto& doc_freq)
+				for (const PlannedTerm& term : *terms)
+				{
+					const auto& postings = term_postings_[term.term_id];
+					const auto add_posting = [&plan, &term, &document_to_relevance, &document_matcher](Ordinal ordinal, Score term_freq)
 					{
-						const auto& document_data = documents_.at(doc_freq.first);
-						if (document_predicate(doc_freq.first, document_data.status, document_data.rating))
+						if (!plan.excluded_documents.Test(ordinal) && document_matcher(ordinal))
 						{
-							document_to_relevance[doc_freq.first].ref_to_value += doc_freq.second * inverse_document_freq;
+							document_to_relevance[ordinal].ref_to_value += term_freq * term.inverse_document_freq;
 						}
-					});
+					};
+					if (postings.IsBitmap())
+					{
+						if (bitmap_count++ % parallelism == task)
+						{
+							postings.ForEach([&add_posting, &task_scanned_postings](Ordinal ordinal, Score term_freq)
+								{
+									++task_scanned_postings;
+									add_posting(ordinal, term_freq);
+								});
+						}
+						continue;
+					}
+					const size_t capacity = postings.GetCapacity();
+					const size_t begin = capacity * task / parallelism;
+					const size_t end = capacity * (task + 1) / parallelism;
+					const Ordinal* ordinals = postings.GetDocumentIds();
+					const Score* term_freqs = postings.GetFrequencies();
+					// освобождённые места списка тоже читаются
+					task_scanned_postings += end - begin;
+					for (size_t position = begin; position < end; ++position)
+					{
+						if (term_freqs[position] != Score{})
+						{
+							add_posting(ordinals[position], term_freqs[position]);
+						}
+					}
+				}
 			}
+			scanned_postings.fetch_add(task_scanned_postings, std::memory_order_relaxed);
 		});
 
-	std::atomic_int size = 0;
-	const std::map<int, double>& ord_map = document_to_relevance.BuildOrdinaryMap();
+	const std::pmr::map<Ordinal, Score> ord_map = document_to_relevance.BuildOrdinaryMap(resource);
+	if (profile)
+	{
+		profile->postings_scanned = scanned_postings;
+		profile->accumulator_size = ord_map.size();
+		profile->lock_acquisitions = document_to_relevance.GetLockAcquisitions();
+	}
 	std::vector<Document> matched_documents(ord_map.size());
 
-	std::for_each(std::execution::par,
+	std::transform(std::execution::par,
 		ord_map.begin(), ord_map.end(),
-		[&matched_documents, this, &size](const auto& map)
+		matched_documents.begin(),
+		[this](const auto& document_relevance)
 		{
-			int document_id = map.first;
-			double relevance = map.second;
-			matched_documents[size++] = { document_id, relevance, documents_.at(document_id).rating };
+			return Document{ document_table_.GetId(document_relevance.first), document_relevance.second, document_table_.GetRating(document_relevance.first) };
 		});
 
-	matched_documents.resize(size);
+	return matched_documents;
+}
+
+template <typename Traits>
+template <typename DocumentMatcher>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindAllDocumentsDense(const QueryPlan& plan, DocumentMatcher document_matcher, std::pmr::memory_resource* resource, QueryProfile* profile) const
+{
+	const ScoreKernels<Score>& kernels = GetScoreKernels<Score>();
+
+	// Вхождения суммируются без проверки фильтров; исключённые и не прошедшие фильтр
+	// документы отбрасываются один раз при просмотре аккумулятора
+	std::pmr::vector<Score> document_to_relevance(document_table_.GetCapacity(), Score{}, resource);
+	size_t scanned_postings = 0;
+	for (const PlannedTerm& term : plan.plus_terms)
+	{
+		const auto& postings = term_postings_[term.term_id];
+		const Score inverse_document_freq = static_cast<Score>(term.inverse_document_freq);
+		if (postings.IsBitmap())
+		{
+			postings.ForEach([&document_to_relevance, &scanned_postings, inverse_document_freq](Ordinal ordinal, Score term_freq)
+				{
+					++scanned_postings;
+					document_to_relevance[ordinal] += term_freq * inverse_document_freq;
+				});
+			continue;
+		}
+		// ядро читает и освобождённые места списка
+		scanned_postings += postings.GetCapacity();
+		kernels.accumulate(postings.GetDocumentIds(), postings.GetFrequencies(), postings.GetCapacity(),
+			inverse_document_freq, document_to_relevance.data());
+	}
+
+	std::vector<Document> matched_documents;
+	std::pmr::vector<uint32_t> positions(DENSE_SCAN_BLOCK_SIZE, resource);
+	for (size_t first = 0; first < document_to_relevance.size(); first += DENSE_SCAN_BLOCK_SIZE)
+	{
+		const size_t count = std::min(DENSE_SCAN_BLOCK_SIZE, document_to_relevance.size() - first);
+		const size_t found = kernels.collect_above(document_to_relevance.data() + first, count, Score{}, positions.data());
+		for (size_t i = 0; i < found; ++i)
+		{
+			const Ordinal ordinal = static_cast<Ordinal>(first + positions[i]);
+			if (!plan.excluded_documents.Test(ordinal) && document_matcher(ordinal))
+			{
+				matched_documents.push_back({ document_table_.GetId(ordinal), document_to_relevance[ordinal], document_table_.GetRating(ordinal) });
+			}
+		}
+	}
+
+	for (const PlannedTerm& term : plan.zero_weight_terms)
+	{
+		for (const auto [ordinal, _] : term_postings_[term.term_id])
+		{
+			++scanned_postings;
+			if (document_to_relevance[ordinal] != Score{})
+			{
+				continue;
+			}
+			// отрицательное значение помечает уже рассмотренный документ
+			document_to_relevance[ordinal] = Score{ -1 };
+			if (!plan.excluded_documents.Test(ordinal) && document_matcher(ordinal))
+			{
+				matched_documents.push_back({ document_table_.GetId(ordinal), Score{}, document_table_.GetRating(ordinal) });
+			}
+		}
+	}
+
+	if (profile)
+	{
+		profile->postings_scanned = scanned_postings;
+		profile->accumulator_size = document_to_relevance.size();
+	}
+
+	return matched_documents;
+}
+
+template <typename Traits>
+template <typename DocumentMatcher>
+std::vector<typename BasicSearchServer<Traits>::Document> BasicSearchServer<Traits>::FindTopDocumentsByImpact(const QueryPlan& plan, DocumentMatcher document_matcher, std::pmr::memory_resource* resource, QueryProfile* profile,
+	size_t count) const
+{
+	using Clock = std::chrono::steady_clock;
+	const auto score_start = Clock::now();
+
+	struct TermCursor
+	{
+		const ImpactIndex::Segment* next;
+		const ImpactIndex::Segment* end;
+		const PostingList<Ordinal, Score>* document_freqs;
+		double inverse_document_freq;
+	};
+
+	std::pmr::vector<TermCursor> cursors(resource);
+	for (const auto* terms : { &plan.plus_terms, &plan.zero_weight_terms })
+	{
+		for (const PlannedTerm& term : *terms)
+		{
+			if (const auto* segments = impact_index_.FindSegments(term.term_id))
+			{
+				cursors.push_back({ segments->data(), segments->data() + segments->size(), &term_postings_[term.term_id], term.inverse_document_freq });
+			}
+		}
+	}
+
+	const uint32_t quantization_slack = static_cast<uint32_t>(cursors.size());
+	const uint32_t* ordinals = impact_index_.GetDocumentIds();
+
+	std::pmr::unordered_map<Ordinal, uint32_t> document_to_impact(resource);
+	DocumentBitmap rejected_documents(resource);
+	std::pmr::vector<uint32_t> impacts(resource);
+	size_t scanned_postings = 0;
+	uint32_t kth_impact = 0;
+
+	while (true)
+	{
+		const auto cursor = std::max_element(cursors.begin(), cursors.end(), [](const TermCursor& lhs, const TermCursor& rhs)
+			{
+				const uint32_t lhs_impact = lhs.next == lhs.end ? 0 : lhs.next->impact;
+				const uint32_t rhs_impact = rhs.next == rhs.end ? 0 : rhs.next->impact;
+				return lhs_impact < rhs_impact || (lhs_impact == rhs_impact && lhs.next == lhs.end && rhs.next != rhs.end);
+			});
+		if (cursor == cursors.end() || cursor->next == cursor->end)
+		{
+			break;
+		}
+
+		const ImpactIndex::Segment& segment = *cursor->next++;
+		for (uint32_t position = segment.begin; position < segment.end; ++position)
+		{
+			const Ordinal ordinal = ordinals[position];
+			if (rejected_documents.Test(ordinal))
+			{
+				continue;
+			}
+			auto it = document_to_impact.find(ordinal);
+			if (it == document_to_impact.end())
+			{
+				if (plan.excluded_documents.Test(ordinal) || !document_matcher(ordinal))
+				{
+					rejected_documents.Set(ordinal);
+					continue;
+				}
+				it = document_to_impact.emplace(ordinal, 0).first;
+			}
+			it->second += segment.impact;
+		}
+		scanned_postings += segment.end - segment.begin;
+
+		if (impact_search_options_.postings_budget > 0 && scanned_postings >= impact_search_options_.postings_budget)
+		{
+			break;
+		}
+		if (document_to_impact.size() < count)
+		{
+			continue;
+		}
+
+		uint32_t remaining_impact = 0;
+		for (const TermCursor& term_cursor : cursors)
+		{
+			remaining_impact += term_cursor.next == term_cursor.end ? 0 : term_cursor.next->impact;
+		}
+
+		impacts.clear();
+		for (const auto [ordinal, impact] : document_to_impact)
+		{
+			impacts.push_back(impact);
+		}
+		const auto kth = impacts.begin() + (count - 1);
+		std::nth_element(impacts.begin(), kth, impacts.end(), std::greater<>());
+		kth_impact = *kth;
+		const uint32_t best_outside_impact = kth + 1 == impacts.end() ? 0 : *std::max_element(kth + 1, impacts.end());
+
+		// квантованный вклад каждого слова завышает точный не больше чем на единицу
+		if (kth_impact > best_outside_impact + remaining_impact + quantization_slack)
+		{
+			break;
+		}
+	}
+
+	if (profile)
+	{
+		profile->postings_scanned = scanned_postings;
+		profile->accumulator_size = document_to_impact.size();
+	}
+
+	const uint32_t candidate_threshold = kth_impact > quantization_slack ? kth_impact - quantization_slack : 0;
+	std::vector<Document> matched_documents;
+	for (const auto [ordinal, impact] : document_to_impact)
+	{
+		if (document_to_impact.size() > count && impact < candidate_threshold)
+		{
+			continue;
+		}
+		Score relevance = 0;
+		for (const TermCursor& term_cursor : cursors)
+		{
+			relevance += term_cursor.document_freqs->Find(ordinal) * term_cursor.inverse_document_freq;
+		}
+		matched_documents.push_back({ document_table_.GetId(ordinal), relevance, document_table_.GetRating(ordinal) });
+	}
+	const auto select_start = Clock::now();
+	SelectTopDocuments(matched_documents, count);
+	if (profile)
+	{
+		profile->score_time = select_start - score_start;
+		profile->select_time = Clock::now() - select_start;
+	}
 
 	return matched_documents;
 }
+
+using SearchServer = BasicSearchServer<DefaultSearchTraits>;
+
+extern template class BasicSearchServer<DefaultSearchTraits>;
+extern template class BasicSearchServer<CompactSearchTraits>;
\ No newline at end of file
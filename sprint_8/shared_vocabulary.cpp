@@ -0,0 +1,108 @@
+#include "shared_vocabulary.h"
+
+#include <algorithm>
+#include <mutex>
+
+std::string_view SharedVocabulary::Intern(std::string_view word, uint64_t hash)
+{
+    {
+        std::shared_lock lock(mutex_);
+        if (const int term_id = dictionary_.Find(word, hash); term_id != TermDictionary::NOT_FOUND)
+        {
+            return words_[term_id];
+        }
+    }
+
+    std::unique_lock lock(mutex_);
+    // слово могли добавить, пока блокировка была отпущена
+    if (const int term_id = dictionary_.Find(word, hash); term_id != TermDictionary::NOT_FOUND)
+    {
+        return words_[term_id];
+    }
+    const std::string_view stored_word = Store(word);
+    const int term_id = static_cast<int>(words_.size());
+    dictionary_.Insert(stored_word, hash, term_id);
+    words_.push_back(stored_word);
+    trie_.Insert(stored_word, term_id);
+    return stored_word;
+}
+
+std::string_view SharedVocabulary::Intern(std::string_view word)
+{
+    return Intern(word, TermDictionary::Hash(word));
+}
+
+int SharedVocabulary::Find(std::string_view word) const
+{
+    std::shared_lock lock(mutex_);
+    return dictionary_.Find(word);
+}
+
+std::string_view SharedVocabulary::GetWord(int term_id) const
+{
+    std::shared_lock lock(mutex_);
+    return words_.at(term_id);
+}
+
+std::vector<std::string_view> SharedVocabulary::FindByPrefix(std::string_view prefix, size_t max_count, const WordPredicate& is_usable) const
+{
+    std::shared_lock lock(mutex_);
+    return ToWords(trie_.FindByPrefix(prefix, max_count, ToTermPredicate(is_usable)));
+}
+
+std::vector<std::string_view> SharedVocabulary::FindWithinDistance(std::string_view word, int max_distance, size_t max_count,
+                                                                   const WordPredicate& is_usable) const
+{
+    std::shared_lock lock(mutex_);
+    return ToWords(trie_.FindWithinDistance(word, max_distance, max_count, ToTermPredicate(is_usable)));
+}
+
+size_t SharedVocabulary::size() const
+{
+    std::shared_lock lock(mutex_);
+    return words_.size();
+}
+
+std::string_view SharedVocabulary::Store(std::string_view word)
+{
+    if (word.size() > CHUNK_SIZE)
+    {
+        chunks_.push_back(std::make_unique<char[]>(word.size()));
+        std::copy(word.begin(), word.end(), chunks_.back().get());
+        // следующее слово начнёт новый блок
+        chunk_used_ = CHUNK_SIZE;
+        return { chunks_.back().get(), word.size() };
+    }
+    if (chunk_used_ + word.size() > CHUNK_SIZE)
+    {
+        chunks_.push_back(std::make_unique<char[]>(CHUNK_SIZE));
+        chunk_used_ = 0;
+    }
+    char* const data = chunks_.back().get() + chunk_used_;
+    std::copy(word.begin(), word.end(), data);
+    chunk_used_ += word.size();
+    return { data, word.size() };
+}
+
+std::vector<std::string_view> SharedVocabulary::ToWords(const std::vector<int>& term_ids) const
+{
+    std::vector<std::string_view> words;
+    words.reserve(term_ids.size());
+    for (const int term_id : term_ids)
+    {
+        words.push_back(words_[term_id]);
+    }
+    return words;
+}
+
+TermTrie::TermPredicate SharedVocabulary::ToTermPredicate(const WordPredicate& is_usable) const
+{
+    if (!is_usable)
+    {
+        return {};
+    }
+    return [this, &is_usable](int term_id)
+    {
+        return is_usable(words_[term_id]);
+    };
+}
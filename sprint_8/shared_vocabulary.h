@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+
+#include "term_dictionary.h"
+#include "term_trie.h"
+
+// Словарь, общий для нескольких серверов: каждое слово хранится один раз и получает
+// глобальный id. Слова только добавляются, поэтому выданные представления действительны,
+// пока жив словарь. Все методы можно вызывать из разных потоков.
+class SharedVocabulary
+{
+public:
+    // Возвращает представление единственной копии слова; hash — значение TermDictionary::Hash(word)
+    std::string_view Intern(std::string_view word, uint64_t hash);
+    std::string_view Intern(std::string_view word);
+
+    // TermDictionary::NOT_FOUND, если слова нет
+    int Find(std::string_view word) const;
+    std::string_view GetWord(int term_id) const;
+
+    using WordPredicate = std::function<bool(std::string_view word)>;
+
+    // Ограничение max_count относится к словам, прошедшим is_usable (пустой пропускает все).
+    // is_usable вызывается под блокировкой словаря и не должен обращаться к нему
+    std::vector<std::string_view> FindByPrefix(std::string_view prefix, size_t max_count, const WordPredicate& is_usable = {}) const;
+    std::vector<std::string_view> FindWithinDistance(std::string_view word, int max_distance, size_t max_count,
+                                                     const WordPredicate& is_usable = {}) const;
+
+    size_t size() const;
+
+private:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    mutable std::shared_mutex mutex_;
+    TermDictionary dictionary_;
+    std::vector<std::string_view> words_;
+    TermTrie trie_;
+
+    // Символы слов лежат подряд в блоках; слово длиннее блока получает собственный блок
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    size_t chunk_used_ = CHUNK_SIZE;
+
+    std::string_view Store(std::string_view word);
+    std::vector<std::string_view> ToWords(const std::vector<int>& term_ids) const;
+    TermTrie::TermPredicate ToTermPredicate(const WordPredicate& is_usable) const;
+};
@@ -0,0 +1,222 @@
+#include "standing_query_index.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std::string_literals;
+
+void StandingQueryIndex::Add(int query_id, const std::vector<StandingQueryTerm>& plus_terms, const std::vector<StandingQueryTerm>& minus_terms)
+{
+    if (queries_.count(query_id) > 0)
+    {
+        throw std::invalid_argument("Standing query id is already registered"s);
+    }
+    if (plus_terms.empty())
+    {
+        throw std::invalid_argument("Standing query has no plus words"s);
+    }
+    std::vector<int> plus_term_ids;
+    std::vector<int> minus_term_ids;
+    std::vector<std::string> plus_words;
+    std::vector<std::string> minus_words;
+    SplitTerms(plus_terms, plus_term_ids, plus_words);
+    SplitTerms(minus_terms, minus_term_ids, minus_words);
+
+    uint32_t slot;
+    if (free_slots_.empty())
+    {
+        slot = static_cast<uint32_t>(slot_to_query_id_.size());
+        slot_to_query_id_.push_back(query_id);
+    }
+    else
+    {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        slot_to_query_id_[slot] = query_id;
+    }
+    Link(term_to_plus_slots_, plus_term_ids, slot);
+    Link(term_to_minus_slots_, minus_term_ids, slot);
+    LinkWords(plus_words, false, slot);
+    LinkWords(minus_words, true, slot);
+    queries_.emplace(query_id, StandingQuery{ slot, std::move(plus_term_ids), std::move(minus_term_ids), std::move(plus_words), std::move(minus_words) });
+}
+
+bool StandingQueryIndex::Remove(int query_id)
+{
+    const auto it = queries_.find(query_id);
+    if (it == queries_.end())
+    {
+        return false;
+    }
+    const uint32_t slot = it->second.slot;
+    Unlink(term_to_plus_slots_, it->second.plus_term_ids, slot);
+    Unlink(term_to_minus_slots_, it->second.minus_term_ids, slot);
+    UnlinkWords(it->second.plus_words, false, slot);
+    UnlinkWords(it->second.minus_words, true, slot);
+    free_slots_.push_back(slot);
+    queries_.erase(it);
+    return true;
+}
+
+void StandingQueryIndex::BindWord(std::string_view word, int term_id)
+{
+    if (unbound_words_.empty())
+    {
+        return;
+    }
+    const auto it = unbound_words_.find(word);
+    if (it == unbound_words_.end())
+    {
+        return;
+    }
+    for (const bool is_minus : { false, true })
+    {
+        for (const uint32_t slot : is_minus ? it->second.minus_slots : it->second.plus_slots)
+        {
+            StandingQuery& query = queries_.at(slot_to_query_id_[slot]);
+            std::vector<std::string>& words = is_minus ? query.minus_words : query.plus_words;
+            words.erase(std::find(words.begin(), words.end(), word));
+            (is_minus ? query.minus_term_ids : query.plus_term_ids).push_back(term_id);
+            Link(is_minus ? term_to_minus_slots_ : term_to_plus_slots_, { term_id }, slot);
+        }
+    }
+    unbound_words_.erase(it);
+}
+
+std::vector<StandingQueryMatch> StandingQueryIndex::Match(const std::vector<WeightedTerm>& terms) const
+{
+    // Рабочие массивы потока не очищаются между вызовами: отметка действительна,
+    // только если равна номеру текущего вызова
+    thread_local std::vector<uint32_t> slot_marks;
+    thread_local std::vector<double> slot_relevances;
+    thread_local uint32_t mark = 0;
+    if (slot_marks.size() < slot_to_query_id_.size())
+    {
+        slot_marks.resize(slot_to_query_id_.size(), 0);
+        slot_relevances.resize(slot_to_query_id_.size());
+    }
+    // отвергнутый запрос помечается mark + 1, подходящий — mark + 2
+    mark += 2;
+    if (mark < 2)
+    {
+        std::fill(slot_marks.begin(), slot_marks.end(), 0);
+        mark = 2;
+    }
+    const uint32_t rejected_mark = mark - 1;
+
+    for (const WeightedTerm& term : terms)
+    {
+        if (static_cast<size_t>(term.term_id) < term_to_minus_slots_.size())
+        {
+            for (const uint32_t slot : term_to_minus_slots_[term.term_id])
+            {
+                slot_marks[slot] = rejected_mark;
+            }
+        }
+    }
+
+    std::vector<uint32_t> matched_slots;
+    for (const WeightedTerm& term : terms)
+    {
+        if (static_cast<size_t>(term.term_id) >= term_to_plus_slots_.size())
+        {
+            continue;
+        }
+        for (const uint32_t slot : term_to_plus_slots_[term.term_id])
+        {
+            if (slot_marks[slot] == mark)
+            {
+                slot_relevances[slot] += term.weight;
+            }
+            else if (slot_marks[slot] != rejected_mark)
+            {
+                slot_marks[slot] = mark;
+                slot_relevances[slot] = term.weight;
+                matched_slots.push_back(slot);
+            }
+        }
+    }
+
+    std::vector<StandingQueryMatch> matches;
+    matches.reserve(matched_slots.size());
+    for (const uint32_t slot : matched_slots)
+    {
+        matches.push_back({ slot_to_query_id_[slot], slot_relevances[slot] });
+    }
+    return matches;
+}
+
+size_t StandingQueryIndex::size() const
+{
+    return queries_.size();
+}
+
+bool StandingQueryIndex::empty() const
+{
+    return queries_.empty();
+}
+
+void StandingQueryIndex::SplitTerms(const std::vector<StandingQueryTerm>& terms, std::vector<int>& term_ids, std::vector<std::string>& words)
+{
+    for (const StandingQueryTerm& term : terms)
+    {
+        if (term.term_id >= 0)
+        {
+            term_ids.push_back(term.term_id);
+        }
+        else
+        {
+            words.emplace_back(term.word);
+        }
+    }
+    std::sort(term_ids.begin(), term_ids.end());
+    term_ids.erase(std::unique(term_ids.begin(), term_ids.end()), term_ids.end());
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+}
+
+void StandingQueryIndex::LinkWords(const std::vector<std::string>& words, bool is_minus, uint32_t slot)
+{
+    for (const std::string& word : words)
+    {
+        UnboundWord& unbound_word = unbound_words_[word];
+        (is_minus ? unbound_word.minus_slots : unbound_word.plus_slots).push_back(slot);
+    }
+}
+
+void StandingQueryIndex::UnlinkWords(const std::vector<std::string>& words, bool is_minus, uint32_t slot)
+{
+    for (const std::string& word : words)
+    {
+        const auto it = unbound_words_.find(word);
+        std::vector<uint32_t>& slots = is_minus ? it->second.minus_slots : it->second.plus_slots;
+        slots.erase(std::find(slots.begin(), slots.end(), slot));
+        if (it->second.plus_slots.empty() && it->second.minus_slots.empty())
+        {
+            unbound_words_.erase(it);
+        }
+    }
+}
+
+void StandingQueryIndex::Link(std::vector<std::vector<uint32_t>>& term_to_slots, const std::vector<int>& term_ids, uint32_t slot)
+{
+    for (const int term_id : term_ids)
+    {
+        if (static_cast<size_t>(term_id) >= term_to_slots.size())
+        {
+            term_to_slots.resize(term_id + 1);
+        }
+        term_to_slots[term_id].push_back(slot);
+    }
+}
+
+void StandingQueryIndex::Unlink(std::vector<std::vector<uint32_t>>& term_to_slots, const std::vector<int>& term_ids, uint32_t slot)
+{
+    for (const int term_id : term_ids)
+    {
+        std::vector<uint32_t>& slots = term_to_slots[term_id];
+        slots.erase(std::find(slots.begin(), slots.end(), slot));
+    }
+}
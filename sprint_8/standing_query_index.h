@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct StandingQueryMatch
+{
+    int query_id = 0;
+    double relevance = 0.0;
+};
+
+struct WeightedTerm
+{
+    int term_id = 0;
+    double weight = 0.0;
+};
+
+struct StandingQueryTerm
+{
+    std::string_view word;
+    // отрицательный, если слова ещё нет ни в одном документе
+    int term_id = -1;
+};
+
+// Сохранённые запросы, проиндексированные по словам. Документ подходит запросу так же,
+// как в FindTopDocuments: в нём есть хотя бы одно плюс-слово запроса и нет ни одного
+// минус-слова. Поэтому запрос записывается в списки всех своих плюс- и минус-слов,
+// и проверка документа просматривает только списки его слов.
+// Слова запросов, которых ещё нет ни в одном документе, хранятся строками в самом
+// индексе, а не в словаре сервера, и получают id терма в BindWord.
+class StandingQueryIndex
+{
+public:
+    // Бросает std::invalid_argument, если query_id занят или у запроса нет плюс-слов
+    void Add(int query_id, const std::vector<StandingQueryTerm>& plus_terms, const std::vector<StandingQueryTerm>& minus_terms);
+    bool Remove(int query_id);
+
+    // Вызывается, когда слово впервые попадает в словарь сервера из документа
+    void BindWord(std::string_view word, int term_id);
+
+    // terms — слова документа с их вкладом в релевантность. Порядок результата не задан:
+    // документ может подходить тысячам запросов, и сортировка обошлась бы дороже поиска
+    std::vector<StandingQueryMatch> Match(const std::vector<WeightedTerm>& terms) const;
+
+    size_t size() const;
+    bool empty() const;
+
+private:
+    struct StandingQuery
+    {
+        uint32_t slot;
+        std::vector<int> plus_term_ids;
+        std::vector<int> minus_term_ids;
+        // слова без id терма
+        std::vector<std::string> plus_words;
+        std::vector<std::string> minus_words;
+    };
+    struct UnboundWord
+    {
+        std::vector<uint32_t> plus_slots;
+        std::vector<uint32_t> minus_slots;
+    };
+
+    std::map<int, StandingQuery> queries_;
+    // Списки слов хранят плотные номера запросов, чтобы проверка документа накапливала
+    // релевантности в массиве; номера удалённых запросов переиспользуются
+    std::vector<int> slot_to_query_id_;
+    std::vector<uint32_t> free_slots_;
+    // Индексируются id терма
+    std::vector<std::vector<uint32_t>> term_to_plus_slots_;
+    std::vector<std::vector<uint32_t>> term_to_minus_slots_;
+    // Удаляется, когда на слово не ссылается ни один запрос
+    std::map<std::string, UnboundWord, std::less<>> unbound_words_;
+
+    static void SplitTerms(const std::vector<StandingQueryTerm>& terms, std::vector<int>& term_ids, std::vector<std::string>& words);
+    void LinkWords(const std::vector<std::string>& words, bool is_minus, uint32_t slot);
+    void UnlinkWords(const std::vector<std::string>& words, bool is_minus, uint32_t slot);
+    static void Link(std::vector<std::vector<uint32_t>>& term_to_slots, const std::vector<int>& term_ids, uint32_t slot);
+    static void Unlink(std::vector<std::vector<uint32_t>>& term_to_slots, const std::vector<int>& term_ids, uint32_t slot);
+};
@@ -30,21 +30,33 @@ vector<string> SplitIntoWords(const string& text)
 	return words;
 }
 
-vector<string_view> SplitIntoWords(const string_view text)
+namespace
 {
-
-	vector<string_view> words;
-
-	string word;
-	auto pos = text.find(' ');
-	size_t first = 0;
-	while (pos != text.npos)
+	template <typename Words>
+	void SplitIntoWordViews(const string_view text, Words& words)
 	{
+		auto pos = text.find(' ');
+		size_t first = 0;
+		while (pos != text.npos)
+		{
+			words.push_back(text.substr(first, pos - first));
+			first = pos + 1;
+			pos = text.find(' ', first);
+		}
 		words.push_back(text.substr(first, pos - first));
-		first = pos + 1;
-		pos = text.find(' ', first);
 	}
-	words.push_back(text.substr(first, pos - first));
+}
+
+vector<string_view> SplitIntoWords(const string_view text)
+{
+	vector<string_view> words;
+	SplitIntoWordViews(text, words);
 	return words;
 }
 
+pmr::vector<string_view> SplitIntoWords(const string_view text, pmr::memory_resource* resource)
+{
+	pmr::vector<string_view> words(resource);
+	SplitIntoWordViews(text, words);
+	return words;
+}
@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include <string_view>
+#include <memory_resource>
 #include"search_server.h"
 
 template <typename StringContainer>
@@ -21,3 +22,4 @@ std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContain
 
 std::vector<std::string> SplitIntoWords(const std::string& text);
 std::vector<std::string_view> SplitIntoWords(const std::string_view text);
+std::pmr::vector<std::string_view> SplitIntoWords(const std::string_view text, std::pmr::memory_resource* resource);
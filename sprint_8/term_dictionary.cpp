@@ -0,0 +1,119 @@
+#include "term_dictionary.h"
+
+#include <functional>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+TermDictionary::TermDictionary()
+    : controls_(GROUP_SIZE, EMPTY), slots_(GROUP_SIZE)
+{
+}
+
+uint64_t TermDictionary::Hash(std::string_view word)
+{
+    return std::hash<std::string_view>{}(word);
+}
+
+int TermDictionary::Find(std::string_view word) const
+{
+    return Find(word, Hash(word));
+}
+
+int TermDictionary::Find(std::string_view word, uint64_t hash) const
+{
+    const int8_t control = GetControl(hash);
+    const size_t group_mask = GetGroupMask();
+    size_t group = (hash >> 7) & group_mask;
+    for (size_t step = 1;; ++step)
+    {
+        for (uint32_t matches = MatchGroup(group, control); matches != 0; matches &= matches - 1)
+        {
+            const Slot& slot = slots_[group * GROUP_SIZE + __builtin_ctz(matches)];
+            if (slot.word == word)
+            {
+                return slot.term_id;
+            }
+        }
+        if (MatchGroup(group, EMPTY) != 0)
+        {
+            return NOT_FOUND;
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+void TermDictionary::Insert(std::string_view word, uint64_t hash, int term_id)
+{
+    // заполненность не больше 7/8, иначе цепочки проб становятся длинными
+    if ((size_ + 1) * 8 > slots_.size() * 7)
+    {
+        Grow();
+    }
+    Place(word, hash, term_id);
+    ++size_;
+}
+
+size_t TermDictionary::size() const
+{
+    return size_;
+}
+
+int8_t TermDictionary::GetControl(uint64_t hash)
+{
+    return static_cast<int8_t>(hash & 0x7F);
+}
+
+size_t TermDictionary::GetGroupMask() const
+{
+    return slots_.size() / GROUP_SIZE - 1;
+}
+
+uint32_t TermDictionary::MatchGroup(size_t group, int8_t control) const
+{
+    const int8_t* controls = controls_.data() + group * GROUP_SIZE;
+#ifdef __SSE2__
+    const __m128i group_controls = _mm_loadu_si128(reinterpret_cast<const __m128i*>(controls));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group_controls, _mm_set1_epi8(control))));
+#else
+    uint32_t matches = 0;
+    for (size_t i = 0; i < GROUP_SIZE; ++i)
+    {
+        matches |= static_cast<uint32_t>(controls[i] == control) << i;
+    }
+    return matches;
+#endif
+}
+
+void TermDictionary::Place(std::string_view word, uint64_t hash, int term_id)
+{
+    const size_t group_mask = GetGroupMask();
+    size_t group = (hash >> 7) & group_mask;
+    for (size_t step = 1;; ++step)
+    {
+        if (const uint32_t empty = MatchGroup(group, EMPTY); empty != 0)
+        {
+            const size_t position = group * GROUP_SIZE + __builtin_ctz(empty);
+            controls_[position] = GetControl(hash);
+            slots_[position] = { word, term_id };
+            return;
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+void TermDictionary::Grow()
+{
+    std::vector<int8_t> controls(controls_.size() * 2, EMPTY);
+    std::vector<Slot> slots(slots_.size() * 2);
+    controls.swap(controls_);
+    slots.swap(slots_);
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        if (controls[i] != EMPTY)
+        {
+            Place(slots[i].word, Hash(slots[i].word), slots[i].term_id);
+        }
+    }
+}
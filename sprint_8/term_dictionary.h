@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Хеш-таблица с открытой адресацией из слов в id термов по образцу Swiss table.
+// Каждой ячейке соответствует байт управления с семью младшими битами хеша её слова,
+// и поиск сравнивает сразу группу из GROUP_SIZE байтов, а слова — только в ячейках
+// с совпавшим байтом. Термы не удаляются, поэтому пустая ячейка в группе завершает поиск.
+class TermDictionary
+{
+public:
+    static constexpr int NOT_FOUND = -1;
+
+    TermDictionary();
+
+    static uint64_t Hash(std::string_view word);
+
+    int Find(std::string_view word) const;
+    // hash — значение Hash(word), если оно уже посчитано
+    int Find(std::string_view word, uint64_t hash) const;
+    // Слова ещё не должно быть в словаре; строка word должна жить не меньше словаря
+    void Insert(std::string_view word, uint64_t hash, int term_id);
+
+    size_t size() const;
+
+private:
+    static constexpr size_t GROUP_SIZE = 16;
+    static constexpr int8_t EMPTY = -128;
+
+    struct Slot
+    {
+        std::string_view word;
+        int term_id;
+    };
+
+    std::vector<int8_t> controls_;
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+
+    static int8_t GetControl(uint64_t hash);
+    size_t GetGroupMask() const;
+    // Биты позиций группы, байт управления которых равен control
+    uint32_t MatchGroup(size_t group, int8_t control) const;
+    void Place(std::string_view word, uint64_t hash, int term_id);
+    void Grow();
+};
@@ -0,0 +1,141 @@
+#include "term_trie.h"
+
+#include <algorithm>
+#include <numeric>
+
+TermTrie::TermTrie()
+    : nodes_(1, Node{ 0, NO_NODE, NO_NODE, -1 })
+{
+}
+
+int32_t TermTrie::FindChild(int32_t node, unsigned char label) const
+{
+    for (int32_t child = nodes_[node].first_child; child != NO_NODE; child = nodes_[child].next_sibling)
+    {
+        if (nodes_[child].label == label)
+        {
+            return child;
+        }
+        if (nodes_[child].label > label)
+        {
+            break;
+        }
+    }
+    return NO_NODE;
+}
+
+int32_t TermTrie::AddChild(int32_t node, unsigned char label)
+{
+    int32_t previous = NO_NODE;
+    int32_t current = nodes_[node].first_child;
+    while (current != NO_NODE && nodes_[current].label < label)
+    {
+        previous = current;
+        current = nodes_[current].next_sibling;
+    }
+    if (current != NO_NODE && nodes_[current].label == label)
+    {
+        return current;
+    }
+
+    const int32_t child = static_cast<int32_t>(nodes_.size());
+    nodes_.push_back(Node{ label, NO_NODE, current, -1 });
+    if (previous == NO_NODE)
+    {
+        nodes_[node].first_child = child;
+    }
+    else
+    {
+        nodes_[previous].next_sibling = child;
+    }
+    return child;
+}
+
+void TermTrie::Insert(std::string_view term, int term_id)
+{
+    int32_t node = 0;
+    for (const char c : term)
+    {
+        node = AddChild(node, static_cast<unsigned char>(c));
+    }
+    nodes_[node].term_id = term_id;
+}
+
+bool TermTrie::IsUsable(int term_id, const TermPredicate& is_usable)
+{
+    return term_id >= 0 && (!is_usable || is_usable(term_id));
+}
+
+std::vector<int> TermTrie::FindByPrefix(std::string_view prefix, size_t max_count, const TermPredicate& is_usable) const
+{
+    std::vector<int> result;
+    int32_t node = 0;
+    for (const char c : prefix)
+    {
+        node = FindChild(node, static_cast<unsigned char>(c));
+        if (node == NO_NODE)
+        {
+            return result;
+        }
+    }
+    CollectSubtree(node, max_count, is_usable, result);
+    return result;
+}
+
+void TermTrie::CollectSubtree(int32_t node, size_t max_count, const TermPredicate& is_usable, std::vector<int>& result) const
+{
+    if (result.size() >= max_count)
+    {
+        return;
+    }
+    if (IsUsable(nodes_[node].term_id, is_usable))
+    {
+        result.push_back(nodes_[node].term_id);
+    }
+    for (int32_t child = nodes_[node].first_child; child != NO_NODE && result.size() < max_count; child = nodes_[child].next_sibling)
+    {
+        CollectSubtree(child, max_count, is_usable, result);
+    }
+}
+
+std::vector<int> TermTrie::FindWithinDistance(std::string_view word, int max_distance, size_t max_count, const TermPredicate& is_usable) const
+{
+    std::vector<int> result;
+    std::vector<int> first_row(word.size() + 1);
+    std::iota(first_row.begin(), first_row.end(), 0);
+
+    if (first_row.back() <= max_distance && max_count > 0 && IsUsable(nodes_[0].term_id, is_usable))
+    {
+        result.push_back(nodes_[0].term_id);
+    }
+    for (int32_t child = nodes_[0].first_child; child != NO_NODE && result.size() < max_count; child = nodes_[child].next_sibling)
+    {
+        CollectWithinDistance(child, word, max_distance, first_row, max_count, is_usable, result);
+    }
+    return result;
+}
+
+void TermTrie::CollectWithinDistance(int32_t node, std::string_view word, int max_distance, const std::vector<int>& previous_row,
+    size_t max_count, const TermPredicate& is_usable, std::vector<int>& result) const
+{
+    std::vector<int> row(previous_row.size());
+    row[0] = previous_row[0] + 1;
+    for (size_t i = 1; i < row.size(); ++i)
+    {
+        const int substitution_cost = static_cast<unsigned char>(word[i - 1]) == nodes_[node].label ? 0 : 1;
+        row[i] = std::min({ row[i - 1] + 1, previous_row[i] + 1, previous_row[i - 1] + substitution_cost });
+    }
+
+    if (row.back() <= max_distance && IsUsable(nodes_[node].term_id, is_usable))
+    {
+        result.push_back(nodes_[node].term_id);
+    }
+    if (*std::min_element(row.begin(), row.end()) > max_distance)
+    {
+        return;
+    }
+    for (int32_t child = nodes_[node].first_child; child != NO_NODE && result.size() < max_count; child = nodes_[child].next_sibling)
+    {
+        CollectWithinDistance(child, word, max_distance, row, max_count, is_usable, result);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+// Словарь термов в виде префиксного дерева. Узлы хранятся в одном векторе
+// (левый ребёнок — правый брат), братья упорядочены по символу, поэтому обход
+// выдаёт термы в лексикографическом порядке.
+class TermTrie
+{
+public:
+    TermTrie();
+
+    void Insert(std::string_view term, int term_id);
+
+    // Термы не удаляются, поэтому отбором is_usable вызывающий отсекает термы без
+    // документов; в max_count считаются только прошедшие его.
+    using TermPredicate = std::function<bool(int term_id)>;
+
+    // Возвращают не более max_count идентификаторов термов; время работы
+    // пропорционально размеру выдачи, а не размеру словаря.
+    std::vector<int> FindByPrefix(std::string_view prefix, size_t max_count, const TermPredicate& is_usable = {}) const;
+    // Расстояние Левенштейна считается в байтах.
+    std::vector<int> FindWithinDistance(std::string_view word, int max_distance, size_t max_count, const TermPredicate& is_usable = {}) const;
+
+private:
+    static const int32_t NO_NODE = -1;
+
+    struct Node
+    {
+        unsigned char label;
+        int32_t first_child;
+        int32_t next_sibling;
+        int32_t term_id;
+    };
+
+    std::vector<Node> nodes_;
+
+    int32_t FindChild(int32_t node, unsigned char label) const;
+    int32_t AddChild(int32_t node, unsigned char label);
+
+    static bool IsUsable(int term_id, const TermPredicate& is_usable);
+
+    void CollectSubtree(int32_t node, size_t max_count, const TermPredicate& is_usable, std::vector<int>& result) const;
+    void CollectWithinDistance(int32_t node, std::string_view word, int max_distance, const std::vector<int>& previous_row,
+        size_t max_count, const TermPredicate& is_usable, std::vector<int>& result) const;
+};
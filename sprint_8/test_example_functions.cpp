@@ -1,5 +1,12 @@
 #include "test_example_functions.h"
 
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include <sys/resource.h>
+
 using namespace std;
 
 template <typename T, typename U>
@@ -133,6 +140,28 @@ void TestMatchDocument() {
         ASSERT_EQUAL(words.size(), 0);
     }
 }
+// Тест проверяет пакетное сопоставление запроса со страницей документов
+void TestMatchDocuments() {
+    SearchServer server("and"s);
+    server.AddDocument(1, "happy dog and lucky cat"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "sad cat"s, DocumentStatus::BANNED, { 2 });
+    server.AddDocument(3, "happy parrot"s, DocumentStatus::ACTUAL, { 3 });
+
+    const auto matches = server.MatchDocuments("happy cat -parrot and"s, { 1, 2, 3 });
+    ASSERT_EQUAL(matches.size(), 3u);
+
+    const auto& [words_1, status_1] = matches[0];
+    ASSERT_EQUAL(words_1.size(), 2u);
+    ASSERT(words_1[0] == "cat"sv && words_1[1] == "happy"sv);
+    ASSERT(status_1 == DocumentStatus::ACTUAL);
+
+    const auto& [words_2, status_2] = matches[1];
+    ASSERT_EQUAL(words_2.size(), 1u);
+    ASSERT(status_2 == DocumentStatus::BANNED);
+
+    ASSERT(get<0>(matches[2]).empty());
+    ASSERT(get<0>(server.MatchDocument(execution::par, "happy cat -parrot"s, 1)) == words_1);
+}
 // Тест проверяет вычисление релевантности документа
 void TestRelevanceDocument() {
     SearchServer server;
@@ -213,15 +242,1302 @@ void TestChoiseOfStatusDocument() {
     ASSERT_EQUAL(doc0.id, 3u); }
 }
 
+// Тест проверяет отбор по структурированному фильтру статуса и диапазона рейтинга
+void TestDocumentFilter() {
+    SearchServer server;
+    server.AddDocument(0, "белый кот"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(1, "пушистый кот"s, DocumentStatus::ACTUAL, { 5 });
+    server.AddDocument(2, "модный кот"s, DocumentStatus::BANNED, { 5 });
+    server.AddDocument(3, "пушистый пёс"s, DocumentStatus::ACTUAL, { 9 });
+
+    DocumentFilter filter;
+    filter.status = DocumentStatus::ACTUAL;
+    filter.min_rating = 2;
+    filter.max_rating = 8;
+    auto found_docs = server.FindTopDocuments("кот пёс"s, filter);
+    ASSERT_EQUAL(found_docs.size(), 1u);
+    ASSERT_EQUAL(found_docs[0].id, 1);
+
+    found_docs = server.FindTopDocuments(execution::par, "кот"s, DocumentFilter{ nullopt, 5 });
+    ASSERT_EQUAL(found_docs.size(), 2u);
+
+    server.RemoveDocument(1);
+    ASSERT(server.FindTopDocuments("пушистый"s, filter).empty());
+}
+// Тест проверяет план запроса: порядок плюс-слов и исключение документов с минус-словами
+void TestQueryPlan() {
+    SearchServer server;
+    server.AddDocument(0, "кот пёс"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(1, "кот скворец"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(2, "кот пёс хвост"s, DocumentStatus::ACTUAL, { 3 });
+
+    const QueryPlan plan = server.ExplainQuery("пёс кот скворец -хвост пёс"s);
+    ASSERT_EQUAL(plan.plus_terms.size(), 2u);
+    ASSERT(plan.plus_terms[0].word == "скворец"sv);
+    ASSERT(plan.plus_terms[1].word == "пёс"sv);
+    ASSERT_EQUAL(plan.zero_weight_terms.size(), 1u);
+    ASSERT_EQUAL(plan.excluded_document_count, 1u);
+
+    for (const auto& found_docs : { server.FindTopDocuments("пёс -хвост"s), server.FindTopDocuments(execution::par, "пёс -хвост"s) }) {
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        ASSERT_EQUAL(found_docs[0].id, 0);
+    }
+    ASSERT_EQUAL(server.FindTopDocuments(execution::par, "кот -хвост"s).size(), 2u);
+}
+// Тест проверяет раскрытие префиксных и нечётких слов запроса
+void TestTermExpansion() {
+    SearchServer server("and"s);
+    server.AddDocument(0, "cat and dog"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(1, "catalog of cars"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(2, "category theory"s, DocumentStatus::ACTUAL, { 3 });
+    server.AddDocument(3, "cut paper"s, DocumentStatus::ACTUAL, { 4 });
+
+    ASSERT_EQUAL(server.FindTopDocuments("cat*"s).size(), 3u);
+    ASSERT_EQUAL(server.FindTopDocuments("cat* -theory"s).size(), 2u);
+    ASSERT_EQUAL(server.FindTopDocuments("~cat"s).size(), 2u);
+    ASSERT(server.FindTopDocuments("dog -cat*"s).empty());
+
+    const auto [words, status] = server.MatchDocument("catal* ~dig"s, 1);
+    ASSERT_EQUAL(words.size(), 1u);
+    ASSERT(words[0] == "catalog"sv);
+
+    server.SetTermExpansionOptions({ 1, 1 });
+    ASSERT_EQUAL(server.FindTopDocuments("cat*"s).size(), 1u);
+
+    // слово удалённого документа остаётся в словаре, но не занимает место в раскрытии
+    server.RemoveDocument(0);
+    const auto found_docs = server.FindTopDocuments("cat*"s);
+    ASSERT_EQUAL(found_docs.size(), 1u);
+    ASSERT_EQUAL(found_docs[0].id, 1);
+    ASSERT_EQUAL(server.FindTopDocuments("~cat"s).size(), 1u);
+
+    try {
+        server.FindTopDocuments("*"s);
+        ASSERT_HINT(false, "Empty expansion pattern must be rejected"s);
+    }
+    catch (const invalid_argument&) {
+    }
+}
+// Тест проверяет поиск и удаление почти одинаковых документов
+void TestRemoveDuplicates() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(3, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+    try {
+        server.FindNearDuplicates(2, 1.0);
+        ASSERT_HINT(false, "Near-duplicate detection must be enabled explicitly"s);
+    }
+    catch (const invalid_argument&) {
+    }
+    // сигнатуры уже добавленных документов строятся при включении
+    server.EnableNearDuplicateDetection();
+    server.AddDocument(4, "funny pet and curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(5, "funny funny pet and nasty nasty rat"s, DocumentStatus::ACTUAL, { 1, 2 });
+    server.AddDocument(6, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+
+    const vector<int> duplicates = server.FindNearDuplicates(2, 1.0);
+    ASSERT((duplicates == vector<int>{ 3, 4 }));
+
+    const vector<int> removed = server.RemoveDuplicates(execution::par, 1.0);
+    ASSERT((removed == vector<int>{ 3, 4, 5 }));
+    ASSERT_EQUAL(server.GetDocumentCount(), 3);
+    ASSERT(server.FindNearDuplicates(2, 1.0).empty());
+
+    // в цепочке 1 ~ 2 ~ 3 документ 3 похож только на удалённый 2 и остаётся
+    SearchServer chain_server;
+    chain_server.EnableNearDuplicateDetection();
+    chain_server.AddDocument(1, "w1 w2 w3 w4 w5 w6 w7 w8 w9 w10"s, DocumentStatus::ACTUAL, { 1 });
+    chain_server.AddDocument(2, "w2 w3 w4 w5 w6 w7 w8 w9 w10 w11"s, DocumentStatus::ACTUAL, { 1 });
+    chain_server.AddDocument(3, "w3 w4 w5 w6 w7 w8 w9 w10 w11 w12"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT((chain_server.FindNearDuplicates(2, 0.65) == vector<int>{ 1, 3 }));
+    ASSERT((chain_server.FindNearDuplicates(3, 0.65) == vector<int>{ 2 }));
+    ASSERT((chain_server.RemoveDuplicates(0.65) == vector<int>{ 2 }));
+    ASSERT_EQUAL(chain_server.GetDocumentCount(), 2);
+}
+// Тест проверяет постраничную выдачу по курсору
+void TestCursorPagination() {
+    SearchServer server;
+    for (int id = 0; id < 12; ++id) {
+        server.AddDocument(id, id % 3 == 0 ? "кот пёс"s : "кот"s, DocumentStatus::ACTUAL, { id % 4 });
+    }
+    server.AddDocument(12, "скворец"s, DocumentStatus::ACTUAL, { 1 });
+
+    vector<int> all_ids;
+    for (const Document& document : server.FindDocumentsPage("кот пёс"s, nullopt, 100)) {
+        all_ids.push_back(document.id);
+    }
+    ASSERT_EQUAL(all_ids.size(), 12u);
+
+    vector<int> paged_ids;
+    size_t page_count = 0;
+    for (const auto& page : PaginateSearch(server, "кот пёс"s, 5)) {
+        ASSERT(page.size() <= 5u);
+        ++page_count;
+        for (const Document& document : page) {
+            paged_ids.push_back(document.id);
+        }
+    }
+    ASSERT_EQUAL(page_count, 3u);
+    ASSERT(paged_ids == all_ids);
+
+    const Document last = server.FindDocumentsPage("кот пёс"s, nullopt, 5)[4];
+    const auto next_page = server.FindDocumentsPage("кот пёс"s, SearchCursor{ last.relevance, last.rating, last.id }, 2, DocumentFilter{});
+    ASSERT_EQUAL(next_page.size(), 2u);
+    ASSERT_EQUAL(next_page[0].id, all_ids[5]);
+    ASSERT_EQUAL(next_page[1].id, all_ids[6]);
+
+    // с индексом вкладов страницы те же, что и при полном подсчёте
+    server.BuildImpactIndex();
+    server.SetImpactSearchOptions({ true, 0 });
+    vector<int> impact_paged_ids;
+    for (const auto& page : PaginateSearch(server, "кот пёс"s, 5)) {
+        ASSERT(page.size() <= 5u);
+        for (const Document& document : page) {
+            impact_paged_ids.push_back(document.id);
+        }
+    }
+    ASSERT(impact_paged_ids == all_ids);
+    ASSERT(server.FindDocumentsPage("кот пёс"s, nullopt, 0).empty());
+}
+// Тест проверяет автоматический выбор политики выполнения запроса
+void TestAdaptiveExecution() {
+    SearchServer server;
+    server.AddDocument(0, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(1, "пушистый кот пушистый хвост"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "ухоженный пёс выразительные глаза"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+
+    server.SetParallelThreshold(1'000'000);
+    const auto sequential_docs = server.FindTopDocuments("пушистый ухоженный кот"s);
+    ExecutionStats stats = server.GetExecutionStats();
+    ASSERT_EQUAL(stats.sequential_queries, 1u);
+    ASSERT_EQUAL(stats.sequential_postings, 4u);
+
+    server.SetParallelThreshold(1);
+    const auto adaptive_docs = server.FindTopDocuments("пушистый ухоженный кот"s);
+    stats = server.GetExecutionStats();
+    if (thread::hardware_concurrency() > 1) {
+        ASSERT_EQUAL(stats.parallel_queries, 1u);
+        // число задач выбирается между двумя и числом потоков
+        ASSERT(stats.parallel_tasks >= 2u && stats.parallel_tasks <= thread::hardware_concurrency());
+    }
+    else {
+        ASSERT_EQUAL(stats.parallel_queries, 0u);
+        ASSERT_EQUAL(stats.parallel_tasks, 0u);
+    }
+    ASSERT_EQUAL(adaptive_docs.size(), sequential_docs.size());
+    for (size_t i = 0; i < adaptive_docs.size(); ++i) {
+        ASSERT_EQUAL(adaptive_docs[i].id, sequential_docs[i].id);
+    }
+}
+// Тест проверяет, что временные данные запроса берутся из арены потока
+void TestQueryArena() {
+    SearchServer server("и в на"s);
+    server.AddDocument(0, "белый кот и модный ошейник"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(1, "пушистый кот пушистый хвост"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "ухоженный пёс выразительные глаза"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+
+    // первый запрос прогревает арену, второй уже не обращается к глобальной куче
+    // ни за чем, кроме возвращаемого вектора
+    server.FindTopDocuments(execution::seq, "пушистый ухоженный кот -ошейник"s);
+    const auto found_docs = server.FindTopDocuments(execution::seq, "пушистый ухоженный кот -ошейник"s);
+    ASSERT_EQUAL(found_docs.size(), 2u);
+    const QueryAllocationStats stats = QueryArena::ForCurrentThread().GetLastQueryStats();
+    ASSERT(stats.arena_allocations > 0u);
+    ASSERT(stats.arena_bytes > 0u);
+    ASSERT_EQUAL(stats.upstream_allocations, 0u);
+
+    // вложенная область не освобождает память внешней
+    {
+        const QueryArenaScope outer;
+        auto* outer_bytes = static_cast<char*>(outer.Resource()->allocate(256));
+        fill(outer_bytes, outer_bytes + 256, 'o');
+        {
+            const QueryArenaScope inner;
+            auto* inner_bytes = static_cast<char*>(inner.Resource()->allocate(256));
+            fill(inner_bytes, inner_bytes + 256, 'i');
+        }
+        ASSERT_EQUAL(QueryArena::ForCurrentThread().GetLastQueryStats().arena_allocations, stats.arena_allocations);
+        auto* next_bytes = static_cast<char*>(outer.Resource()->allocate(256));
+        fill(next_bytes, next_bytes + 256, 'n');
+        ASSERT(all_of(outer_bytes, outer_bytes + 256, [](char c) { return c == 'o'; }));
+    }
+    ASSERT_EQUAL(QueryArena::ForCurrentThread().GetLastQueryStats().arena_allocations, 3u);
+
+    // параллельный путь тоже берёт корзины аккумулятора из арены
+    server.FindTopDocuments(execution::par, "пушистый ухоженный кот -ошейник"s);
+    const auto par_docs = server.FindTopDocuments(execution::par, "пушистый ухоженный кот -ошейник"s);
+    ASSERT_EQUAL(par_docs.size(), found_docs.size());
+    const QueryAllocationStats par_stats = QueryArena::ForCurrentThread().GetLastQueryStats();
+    ASSERT(par_stats.arena_allocations > 0u);
+    ASSERT_EQUAL(par_stats.upstream_allocations, 0u);
+    {
+        const QueryArenaScope arena;
+        ConcurrentMap<int, int> accumulator(10, arena.Resource());
+        for (int key = 0; key < 20; ++key) {
+            accumulator[key].ref_to_value += key;
+        }
+    }
+    // массив корзин и по одному блоку на каждую корзину
+    ASSERT_EQUAL(QueryArena::ForCurrentThread().GetLastQueryStats().arena_allocations, 11u);
+}
+// Тест проверяет, что поиск по индексу вкладов находит те же документы, что и полный перебор
+void TestImpactOrderedSearch() {
+    mt19937 generator(42);
+    const auto dictionary = GenerateDictionary(generator, 300, 6);
+    SearchServer server;
+    AddGeneratedDocuments(server, generator, dictionary, 2'000, 20);
+    const auto queries = GenerateQueries(generator, dictionary, 50, 4);
+
+    vector<vector<Document>> expected;
+    for (const string& query : queries) {
+        expected.push_back(server.FindTopDocuments(query));
+    }
+
+    server.BuildImpactIndex();
+    server.SetImpactSearchOptions({ true, 0 });
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto found_docs = server.FindTopDocuments(queries[i]);
+        ASSERT_EQUAL(found_docs.size(), expected[i].size());
+        for (size_t j = 0; j < found_docs.size(); ++j) {
+            ASSERT_EQUAL(found_docs[j].id, expected[i][j].id);
+            ASSERT(abs(found_docs[j].relevance - expected[i][j].relevance) < 1e-9);
+        }
+    }
+
+    server.SetImpactSearchOptions({ true, 10 });
+    ASSERT(server.FindTopDocuments(queries[0]).size() <= expected[0].size());
+
+    server.AddDocument(100'000, dictionary[0], DocumentStatus::ACTUAL, { 1 });
+    ASSERT_EQUAL(server.FindTopDocuments(dictionary[0]).front().id, 100'000);
+}
+
+void TestLoadCorpus() {
+    mt19937 generator(7);
+    const auto dictionary = GenerateDictionary(generator, 200, 6);
+    const string path = (filesystem::temp_directory_path() / "search_server_test_corpus.tsv"s).string();
+    WriteGeneratedCorpus(path, generator, dictionary, 500, 15);
+
+    SearchServer expected_server(dictionary[0]);
+    {
+        ifstream in(path);
+        for (string line; getline(in, line);) {
+            const int id = stoi(line);
+            expected_server.AddDocument(id, line.substr(line.find('\t', line.find('\t', line.find('\t') + 1) + 1) + 1),
+                static_cast<DocumentStatus>(id % 4), { id % 7, id % 5 });
+        }
+    }
+
+    for (const bool use_mapped_storage : { false, true }) {
+        SearchServer server(dictionary[0]);
+        CorpusLoadOptions options;
+        options.chunk_size = 1'000;
+        options.tokenizer_count = 3;
+        options.queue_capacity = 2;
+        options.use_mapped_storage = use_mapped_storage;
+        const CorpusLoadStats stats = LoadCorpus(server, path, options);
+        ASSERT_EQUAL(stats.document_count, 500u);
+        ASSERT_EQUAL(server.GetDocumentCount(), 500);
+
+        for (int i = 0; i < 20; ++i) {
+            const string query = GenerateQuery(generator, dictionary, 3);
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                const auto found_docs = server.FindTopDocuments(query, status);
+                const auto expected_docs = expected_server.FindTopDocuments(query, status);
+                ASSERT_EQUAL(found_docs.size(), expected_docs.size());
+                for (size_t j = 0; j < found_docs.size(); ++j) {
+                    ASSERT_EQUAL(found_docs[j].id, expected_docs[j].id);
+                    ASSERT_EQUAL(found_docs[j].rating, expected_docs[j].rating);
+                }
+            }
+        }
+    }
+
+    // пустые слова между пробелами считаются так же, как в AddDocument
+    {
+        ofstream out(path);
+        out << "1\t0\t1\tcat  in the city\n"s << "2\t0\t1\tdog\n"s;
+    }
+    {
+        SearchServer loaded_server;
+        LoadCorpus(loaded_server, path);
+        SearchServer added_server;
+        added_server.AddDocument(1, "cat  in the city"s, DocumentStatus::ACTUAL, { 1 });
+        added_server.AddDocument(2, "dog"s, DocumentStatus::ACTUAL, { 1 });
+        const auto loaded_docs = loaded_server.FindTopDocuments("cat"s);
+        const auto added_docs = added_server.FindTopDocuments("cat"s);
+        ASSERT_EQUAL(loaded_docs.size(), 1u);
+        ASSERT_EQUAL(added_docs.size(), 1u);
+        ASSERT_EQUAL(loaded_docs[0].relevance, added_docs[0].relevance);
+    }
+
+    {
+        ofstream out(path);
+        out << "1\t0\t1 2\tcat in the city\n"s << "2\tbad\t1\tdog\n"s;
+    }
+    SearchServer server;
+    try {
+        LoadCorpus(server, path);
+        ASSERT_HINT(false, "malformed status must be rejected"s);
+    } catch (const invalid_argument&) {
+    }
+    remove(path.c_str());
+}
+
+void TestWriteAheadLog() {
+    const string path = (filesystem::temp_directory_path() / "search_server_test.wal"s).string();
+    remove(path.c_str());
+    {
+        SearchServer server("in the"s);
+        ASSERT_EQUAL(server.OpenWriteAheadLog(path, { 64, chrono::milliseconds(1) }), 0u);
+        server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, { 1, 2, 3 });
+        server.AddDocument(2, "dog in the village"s, DocumentStatus::BANNED, { -4 });
+        server.AddDocument(3, "cat and dog"s, DocumentStatus::ACTUAL, { 5 });
+        server.RemoveDocument(execution::par, 3);
+        server.RemoveDocument(42);
+        ASSERT_EQUAL(server.GetWriteAheadLogStats().records, 4u);
+    }
+    {
+        ofstream out(path, ios::app | ios::binary);
+        out << "torn"s;
+    }
+    {
+        SearchServer server("in the"s);
+        ASSERT_EQUAL(server.OpenWriteAheadLog(path), 4u);
+        ASSERT_EQUAL(server.GetDocumentCount(), 2);
+        const auto found_docs = server.FindTopDocuments("dog"s, DocumentStatus::BANNED);
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        ASSERT_EQUAL(found_docs[0].rating, -4);
+        ASSERT(server.FindTopDocuments("cat"s).size() == 1u);
+
+        server.AddDocument(4, "parrot"s, DocumentStatus::ACTUAL, {});
+        int snapshot_document_count = 0;
+        server.CheckpointWriteAheadLog([&snapshot_document_count](const SearchServer& snapshot) {
+            snapshot_document_count = snapshot.GetDocumentCount();
+        });
+        ASSERT_EQUAL(snapshot_document_count, 3);
+        server.AddDocument(5, "hamster"s, DocumentStatus::ACTUAL, {});
+    }
+    {
+        SearchServer server("in the"s);
+        ASSERT_EQUAL(server.OpenWriteAheadLog(path), 1u);
+        ASSERT_EQUAL(server.GetDocumentCount(), 1);
+        ASSERT_EQUAL(server.FindTopDocuments("hamster"s).size(), 1u);
+    }
+
+    // Ошибка записи: предел размера файла обрывает запись посередине
+    remove(path.c_str());
+    {
+        SearchServer server("in the"s);
+        server.OpenWriteAheadLog(path, { 1, chrono::hours(1) });
+        server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, { 1 });
+        server.AddDocument(2, "dog in the village"s, DocumentStatus::ACTUAL, { 2 });
+        server.SyncWriteAheadLog();
+
+        rlimit original_limit{};
+        getrlimit(RLIMIT_FSIZE, &original_limit);
+        const auto previous_handler = signal(SIGXFSZ, SIG_IGN);
+        rlimit small_limit = original_limit;
+        small_limit.rlim_cur = filesystem::file_size(path) + 10;
+        setrlimit(RLIMIT_FSIZE, &small_limit);
+
+        server.AddDocument(3, "parrot in the cage"s, DocumentStatus::ACTUAL, { 3 });
+        try {
+            // сброс записи документа 3 обрывается, и документ 4 не добавляется
+            server.AddDocument(4, "hamster in the wheel"s, DocumentStatus::ACTUAL, { 4 });
+            ASSERT_HINT(false, "Failed log write must be reported"s);
+        }
+        catch (const invalid_argument&) {
+        }
+        ASSERT_EQUAL(server.GetDocumentCount(), 3);
+        ASSERT(server.FindTopDocuments("hamster"s).empty());
+        try {
+            server.SyncWriteAheadLog();
+            ASSERT_HINT(false, "Unsynced records must stay buffered until the write succeeds"s);
+        }
+        catch (const invalid_argument&) {
+        }
+
+        setrlimit(RLIMIT_FSIZE, &original_limit);
+        signal(SIGXFSZ, previous_handler);
+        server.SyncWriteAheadLog();
+        server.AddDocument(5, "rabbit"s, DocumentStatus::ACTUAL, { 5 });
+    }
+    {
+        SearchServer server("in the"s);
+        ASSERT_EQUAL(server.OpenWriteAheadLog(path), 4u);
+        ASSERT_EQUAL(server.GetDocumentCount(), 4);
+        ASSERT_EQUAL(server.FindTopDocuments("parrot"s).size(), 1u);
+        ASSERT_EQUAL(server.FindTopDocuments("rabbit"s).size(), 1u);
+        ASSERT(server.FindTopDocuments("hamster"s).empty());
+    }
+
+    // пустые слова в начале, в конце и подряд воспроизводятся так же, как при добавлении
+    remove(path.c_str());
+    const vector<string> spaced_texts = { " cat"s, "cat "s, "cat  dog"s, " "s };
+    const auto to_map = [](const auto& word_freqs) {
+        map<string, double> result;
+        for (const auto [word, freq] : word_freqs) {
+            result[string(word)] = freq;
+        }
+        return result;
+    };
+    SearchServer expected_server;
+    {
+        SearchServer server;
+        server.OpenWriteAheadLog(path);
+        for (int id = 0; id < static_cast<int>(spaced_texts.size()); ++id) {
+            server.AddDocument(id, spaced_texts[id], DocumentStatus::ACTUAL, { 1 });
+            expected_server.AddDocument(id, spaced_texts[id], DocumentStatus::ACTUAL, { 1 });
+        }
+    }
+    {
+        SearchServer server;
+        ASSERT_EQUAL(server.OpenWriteAheadLog(path), spaced_texts.size());
+        for (int id = 0; id < static_cast<int>(spaced_texts.size()); ++id) {
+            ASSERT_HINT(to_map(server.GetWordFrequencies(id)) == to_map(expected_server.GetWordFrequencies(id)), spaced_texts[id]);
+        }
+    }
+    ASSERT_EQUAL(to_map(expected_server.GetWordFrequencies(0)).size(), 2u);
+    remove(path.c_str());
+}
+
+void TestWordFrequencies() {
+    SearchServer server("and"s);
+    server.AddDocument(1, "cat and dog and cat"s, DocumentStatus::ACTUAL, { 1 });
+    for (int id = 2; id < 20; ++id) {
+        server.AddDocument(id, "word"s + to_string(id) + " parrot"s, DocumentStatus::ACTUAL, { 1 });
+    }
+
+    map<string_view, double> freqs;
+    for (const auto [word, freq] : server.GetWordFrequencies(1)) {
+        freqs[word] = freq;
+    }
+    ASSERT_EQUAL(freqs.size(), 2u);
+    ASSERT(abs(freqs["cat"s] - 2.0 / 3) < 1e-9);
+    ASSERT(abs(freqs["dog"s] - 1.0 / 3) < 1e-9);
+
+    for (int id = 2; id < 19; ++id) {
+        if (id % 2 == 0) {
+            server.RemoveDocument(execution::par, id);
+        } else {
+            server.RemoveDocument(id);
+        }
+    }
+    ASSERT(server.GetWordFrequencies(5).empty());
+    ASSERT_EQUAL(server.GetWordFrequencies(1).size(), 2u);
+    ASSERT_EQUAL(server.GetWordFrequencies(19).size(), 2u);
+    ASSERT_EQUAL(server.FindTopDocuments("parrot"s).size(), 1u);
+
+    const auto [words, status] = server.MatchDocument("cat dog parrot"s, 1);
+    ASSERT_EQUAL(words.size(), 2u);
+    ASSERT(get<0>(server.MatchDocument("cat -dog"s, 1)).empty());
+}
+
+void TestCompactSearchTraits() {
+    mt19937 generator(11);
+    const auto dictionary = GenerateDictionary(generator, 300, 6);
+    SearchServer server(dictionary[0]);
+    BasicSearchServer<CompactSearchTraits> compact_server(dictionary[0]);
+    for (int id = 0; id < 1'000; ++id) {
+        const string document = GenerateQuery(generator, dictionary, 20);
+        server.AddDocument(id, document, DocumentStatus::ACTUAL, { id % 10 });
+        compact_server.AddDocument(static_cast<uint32_t>(id), document, DocumentStatus::ACTUAL, { id % 10 });
+    }
+
+    for (const string& query : GenerateQueries(generator, dictionary, 30, 4)) {
+        const auto found_docs = server.FindTopDocuments(query);
+        const auto compact_docs = compact_server.FindTopDocuments(query);
+        ASSERT_EQUAL(found_docs.size(), compact_docs.size());
+        for (size_t i = 0; i < found_docs.size(); ++i) {
+            ASSERT(abs(found_docs[i].relevance - compact_docs[i].relevance) < 1e-5);
+        }
+    }
+
+    compact_server.RemoveDocument(3u);
+    ASSERT_EQUAL(compact_server.GetDocumentCount(), 999);
+    ASSERT_EQUAL(*compact_server.begin(), 0u);
+}
+
+void TestScoreKernels() {
+    mt19937 generator(13);
+    const size_t document_count = 1'000;
+    vector<uint32_t> ids;
+    vector<double> freqs;
+    for (uint32_t id = 0; id < document_count; ++id) {
+        if (generator() % 3 == 0) {
+            ids.push_back(id);
+            freqs.push_back((generator() % 100 + 1) / 100.0);
+        }
+    }
+
+    vector<double> expected(document_count);
+    vector<uint32_t> expected_positions(document_count);
+    const auto& scalar = GetScoreKernels<double>(ScoreKernelIsa::SCALAR);
+    scalar.accumulate(ids.data(), freqs.data(), ids.size(), 0.37, expected.data());
+    scalar.accumulate(ids.data(), freqs.data(), ids.size(), 1.13, expected.data());
+    const size_t expected_found = scalar.collect_above(expected.data(), expected.size(), 0.0, expected_positions.data());
+    ASSERT_EQUAL(expected_found, ids.size());
+    for (ScoreKernelIsa isa : { ScoreKernelIsa::AVX2, ScoreKernelIsa::AVX512 }) {
+        const auto& kernels = GetScoreKernels<double>(isa);
+        vector<double> accumulator(document_count);
+        vector<uint32_t> positions(document_count);
+        kernels.accumulate(ids.data(), freqs.data(), ids.size(), 0.37, accumulator.data());
+        kernels.accumulate(ids.data(), freqs.data(), ids.size(), 1.13, accumulator.data());
+        ASSERT(accumulator == expected);
+        ASSERT_EQUAL(kernels.collect_above(accumulator.data(), accumulator.size(), 0.0, positions.data()), expected_found);
+        ASSERT(positions == expected_positions);
+    }
+
+    // Плотный последовательный путь и параллельный путь по дереву дают одно и то же,
+    // в том числе после удаления документов из списков
+    const auto dictionary = GenerateDictionary(generator, 200, 6);
+    SearchServer server(dictionary[0]);
+    for (int id = 0; id < 500; ++id) {
+        server.AddDocument(id, GenerateQuery(generator, dictionary, 15), DocumentStatus::ACTUAL, { id % 7 });
+    }
+    for (int id = 0; id < 500; id += 3) {
+        server.RemoveDocument(id);
+    }
+    for (const string& query : GenerateQueries(generator, dictionary, 30, 4)) {
+        const auto seq_docs = server.FindTopDocuments(execution::seq, query);
+        const auto par_docs = server.FindTopDocuments(execution::par, query);
+        ASSERT_EQUAL(seq_docs.size(), par_docs.size());
+        for (size_t i = 0; i < seq_docs.size(); ++i) {
+            ASSERT_EQUAL(seq_docs[i].id % 3 != 0, true);
+            // параллельный путь складывает вклады слов в произвольном порядке
+            ASSERT(abs(seq_docs[i].relevance - par_docs[i].relevance) < precision);
+        }
+    }
+}
+
+void TestBatchQueries() {
+    mt19937 generator(17);
+    const auto dictionary = GenerateDictionary(generator, 150, 6);
+    SearchServer server(dictionary[0]);
+    for (int id = 0; id < 3'000; ++id) {
+        const DocumentStatus status = id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        server.AddDocument(id, GenerateQuery(generator, dictionary, 12), status, { id % 11 });
+    }
+    for (int id = 1; id < 3'000; id += 7) {
+        server.RemoveDocument(id);
+    }
+
+    vector<string> queries = GenerateQueries(generator, dictionary, 60, 4);
+    for (int i = 0; i < 20; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, 3, 0.3));
+    }
+    // повторы, перестановки слов и запросы без найденных документов
+    queries.push_back(queries[0]);
+    queries.push_back(queries[5]);
+    queries.push_back(dictionary[1] + " "s + dictionary[2]);
+    queries.push_back(dictionary[2] + " "s + dictionary[1]);
+    queries.push_back("unknownword"s);
+
+    const auto results = server.FindTopDocumentsBatch(queries);
+    ASSERT_EQUAL(results.size(), queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto expected = server.FindTopDocuments(execution::seq, queries[i]);
+        ASSERT_EQUAL_HINT(results[i].size(), expected.size(), queries[i]);
+        for (size_t j = 0; j < expected.size(); ++j) {
+            ASSERT_EQUAL(results[i][j].id, expected[j].id);
+            ASSERT_EQUAL(results[i][j].relevance, expected[j].relevance);
+            ASSERT_EQUAL(results[i][j].rating, expected[j].rating);
+        }
+    }
+    ASSERT(results.back().empty());
+
+    const DocumentFilter filter{ DocumentStatus::BANNED, 3, 8 };
+    const auto filtered_results = server.FindTopDocumentsBatch(queries, filter);
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto expected = server.FindTopDocuments(execution::seq, queries[i], filter);
+        ASSERT_EQUAL(filtered_results[i].size(), expected.size());
+        for (size_t j = 0; j < expected.size(); ++j) {
+            ASSERT_EQUAL(filtered_results[i][j].id, expected[j].id);
+            ASSERT_EQUAL(filtered_results[i][j].relevance, expected[j].relevance);
+        }
+    }
+
+    const auto shared_results = ProcessQueriesShared(server, queries);
+    const auto separate_results = ProcessQueries(server, queries);
+    for (size_t i = 0; i < queries.size(); ++i) {
+        ASSERT_EQUAL(shared_results[i].size(), separate_results[i].size());
+        for (size_t j = 0; j < separate_results[i].size(); ++j) {
+            ASSERT_EQUAL(shared_results[i][j].id, separate_results[i][j].id);
+        }
+    }
+}
+
+void TestLoadTest() {
+    mt19937 generator(19);
+    const auto dictionary = GenerateDictionary(generator, 100, 6);
+    SearchServer server(dictionary[0]);
+    AddGeneratedDocuments(server, generator, dictionary, 200, 10);
+    const int document_count = server.GetDocumentCount();
+
+    const string path = "test_query_log.txt"s;
+    {
+        ofstream log(path);
+        log << dictionary[1] << "\n\nunknownword\n"s << dictionary[2] << " "s << dictionary[3] << "\n"s;
+    }
+    const auto queries = ReadQueryLog(path);
+    remove(path.c_str());
+    ASSERT_EQUAL(queries.size(), 3u);
+    ASSERT_EQUAL(queries[1], "unknownword"s);
+
+    LoadTestOptions options;
+    options.queries_per_second = 300;
+    options.duration = chrono::milliseconds(200);
+    options.thread_count = 2;
+    options.mutations_per_second = 100;
+    const auto report = RunLoadTest(server, queries, { GenerateQuery(generator, dictionary, 10) }, options);
+    ASSERT_EQUAL(report.latency.count, 60u);
+    ASSERT_EQUAL(report.mutation_latency.count, 20u);
+    ASSERT(report.latency.p50 <= report.latency.p99 && report.latency.p99 <= report.latency.p999 && report.latency.p999 <= report.latency.max);
+    ASSERT(report.service_time.max <= report.latency.max);
+    // каждый третий запрос ничего не находит
+    ASSERT_EQUAL(report.window_requests, 60u);
+    ASSERT_EQUAL(report.no_result_requests, 20u);
+    ASSERT_EQUAL(server.GetDocumentCount(), document_count);
+
+    options.mutations_per_second = 0;
+    options.batch_size = 3;
+    const auto batch_report = RunLoadTest(server, queries, {}, options);
+    ASSERT_EQUAL(batch_report.latency.count, 20u);
+    ASSERT_EQUAL(batch_report.no_result_requests, 20u);
+
+    for (const string& query : GenerateZipfQueries(generator, dictionary, 10, 3)) {
+        ASSERT(!query.empty());
+    }
+}
+
+void TestDocumentOrdinals() {
+    SearchServer server("and"s);
+    server.AddDocument(2'000'000'000, "white cat"s, DocumentStatus::ACTUAL, { 5 });
+    server.AddDocument(7, "black cat"s, DocumentStatus::BANNED, { 3 });
+    server.AddDocument(500'000, "white dog"s, DocumentStatus::ACTUAL, { 1 });
+
+    const vector<int> ids(server.begin(), server.end());
+    ASSERT(ids == vector<int>({ 7, 500'000, 2'000'000'000 }));
+    ASSERT_EQUAL(*prev(server.end()), 2'000'000'000);
+
+    const auto found_docs = server.FindTopDocuments("white cat"s);
+    ASSERT_EQUAL(found_docs.size(), 2u);
+    ASSERT_EQUAL(found_docs[0].id, 2'000'000'000);
+    ASSERT_EQUAL(found_docs[0].rating, 5);
+    ASSERT_EQUAL(found_docs[1].id, 500'000);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s, DocumentStatus::BANNED)[0].id, 7);
+
+    // новый документ получает свежий номер, номер удалённого остаётся свободным
+    server.RemoveDocument(2'000'000'000);
+    server.AddDocument(42, "white cat"s, DocumentStatus::ACTUAL, { 9 });
+    ASSERT_EQUAL(server.GetDocumentCount(), 3);
+    const auto readded_docs = server.FindTopDocuments("white cat"s);
+    ASSERT_EQUAL(readded_docs.size(), 2u);
+    ASSERT_EQUAL(readded_docs[0].id, 42);
+    ASSERT_EQUAL(readded_docs[0].rating, 9);
+    ASSERT(get<1>(server.MatchDocument("cat"s, 7)) == DocumentStatus::BANNED);
+    ASSERT(server.GetWordFrequencies(2'000'000'000).empty());
+    ASSERT_EQUAL(server.GetWordFrequencies(42).size(), 2u);
+
+    try {
+        server.MatchDocument("cat"s, 2'000'000'000);
+        ASSERT_HINT(false, "MatchDocument must throw for a removed document"s);
+    } catch (const out_of_range&) {
+    }
+
+    // с переиспользованием номер удалённого документа достаётся следующему добавленному
+    server.SetOrdinalReuse(true);
+    server.RemoveDocument(7);
+    server.AddDocument(3, "black dog"s, DocumentStatus::BANNED, { 4 });
+    server.AddDocument(8, "black cat"s, DocumentStatus::ACTUAL, { 2 });
+    ASSERT_EQUAL(server.GetDocumentCount(), 4);
+    const auto reused_docs = server.FindTopDocuments("black"s, DocumentStatus::BANNED);
+    ASSERT_EQUAL(reused_docs.size(), 1u);
+    ASSERT_EQUAL(reused_docs[0].id, 3);
+    ASSERT_EQUAL(reused_docs[0].rating, 4);
+    const auto cat_docs = server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(cat_docs.size(), 2u);
+    ASSERT_EQUAL(cat_docs[0].id, 42);
+    ASSERT_EQUAL(cat_docs[1].id, 8);
+    ASSERT(server.GetWordFrequencies(7).empty());
+}
+
+void TestHighFrequencyTerms() {
+    // "common" есть в трёх документах из четырёх
+    SearchServer server;
+    vector<int> common_ids;
+    for (int id = 0; id < 200; ++id) {
+        const string text = (id % 4 != 0 ? "common "s : ""s) + "w"s + to_string(id % 10) + " unique"s + to_string(id);
+        server.AddDocument(id, text, DocumentStatus::ACTUAL, { id % 7 });
+        if (id % 4 != 0) {
+            common_ids.push_back(id);
+        }
+    }
+    const vector<string> queries = { "common w3"s, "common"s, "w3 -common"s, "comm* w5"s };
+    vector<vector<Document>> expected;
+    for (const string& query : queries) {
+        expected.push_back(server.FindTopDocuments(query));
+    }
+
+    server.SetHighFrequencyTermOptions({ HighFrequencyTermMode::BITMAP, 0.5, 10 });
+    {
+        const HighFrequencyTermReport report = server.GetHighFrequencyTermReport();
+        ASSERT_EQUAL(report.terms.size(), 1u);
+        ASSERT_EQUAL(report.terms[0].word, "common"s);
+        ASSERT_EQUAL(report.terms[0].document_freq, common_ids.size());
+        ASSERT(report.terms[0].bytes < report.terms[0].array_bytes);
+        ASSERT(report.saved_bytes > 0);
+    }
+    // частоты квантованы, поэтому релевантности совпадают лишь приближённо
+    const auto batch_docs = server.FindTopDocumentsBatch(queries);
+    for (size_t i = 0; i < queries.size(); ++i) {
+        for (const auto& found_docs : { server.FindTopDocuments(execution::seq, queries[i]), server.FindTopDocuments(execution::par, queries[i]), batch_docs[i] }) {
+            ASSERT_EQUAL(found_docs.size(), expected[i].size());
+            for (size_t j = 0; j < found_docs.size(); ++j) {
+                ASSERT_EQUAL(found_docs[j].id, expected[i][j].id);
+                ASSERT(abs(found_docs[j].relevance - expected[i][j].relevance) < 1e-3);
+            }
+        }
+    }
+    server.RemoveDocument(1);
+    server.AddDocument(1, "common w1"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT_EQUAL(server.GetHighFrequencyTermReport().terms[0].document_freq, common_ids.size());
+
+    // в режиме DROP слово отбрасывается из запросов, как стоп-слово
+    server.SetHighFrequencyTermOptions({ HighFrequencyTermMode::DROP, 0.0, 100 });
+    ASSERT(server.FindTopDocuments("common"s).empty());
+    ASSERT_EQUAL(server.FindTopDocuments("common w3"s).size(), server.FindTopDocuments("w3"s).size());
+    ASSERT(get<0>(server.MatchDocument("common w3"s, 3)) == vector<string_view>({ "w3"sv }));
+    ASSERT_EQUAL(server.GetHighFrequencyTermReport().terms[0].bytes, 0u);
+
+    // отброшенное слово не занимает место в раскрытии префикса
+    server.AddDocument(1000, "commute"s, DocumentStatus::ACTUAL, { 1 });
+    server.SetTermExpansionOptions({ 1, 1 });
+    const auto commuters = server.FindTopDocuments("comm*"s);
+    ASSERT_EQUAL(commuters.size(), 1u);
+    ASSERT_EQUAL(commuters[0].id, 1000);
+    server.SetTermExpansionOptions({});
+    server.RemoveDocument(1000);
+
+    // ниже половины порога слово возвращается в индекс с точными частотами
+    for (size_t i = 0; i < 101; ++i) {
+        server.RemoveDocument(common_ids[i]);
+    }
+    ASSERT(server.GetHighFrequencyTermReport().terms.empty());
+    ASSERT(abs(server.FindTopDocuments("common"s)[0].relevance - log(99.0 / 49) / 3) < 1e-12);
+
+    server.SetHighFrequencyTermOptions({});
+    try {
+        server.SetHighFrequencyTermOptions({ HighFrequencyTermMode::BITMAP, 1.5, 10 });
+        ASSERT_HINT(false, "SetHighFrequencyTermOptions must reject a fraction above one"s);
+    } catch (const invalid_argument&) {
+    }
+}
+
+void TestRemoveDocuments() {
+    const auto fill_server = [](SearchServer& server, HighFrequencyTermMode mode) {
+        for (int id = 0; id < 300; ++id) {
+            const string text = (id % 3 != 0 ? "common "s : ""s) + "w"s + to_string(id % 10) + " u"s + to_string(id % 37);
+            server.AddDocument(id, text, DocumentStatus::ACTUAL, { id % 5 });
+        }
+        server.SetHighFrequencyTermOptions({ mode, 0.5, 10 });
+    };
+    vector<int> removed_ids;
+    for (int id = 0; id < 300; id += 7) {
+        removed_ids.push_back(id);
+    }
+    // повторы и отсутствующие id пропускаются
+    vector<int> batch = removed_ids;
+    batch.push_back(14);
+    batch.push_back(1000);
+
+    const vector<string> queries = { "common w3"s, "w1 u2"s, "u5 -w5"s, "common"s };
+    for (const HighFrequencyTermMode mode : { HighFrequencyTermMode::KEEP, HighFrequencyTermMode::BITMAP, HighFrequencyTermMode::DROP }) {
+        SearchServer expected;
+        SearchServer sequential;
+        SearchServer parallel;
+        for (SearchServer* server : { &expected, &sequential, &parallel }) {
+            fill_server(*server, mode);
+        }
+        for (const int id : removed_ids) {
+            expected.RemoveDocument(id);
+        }
+        ASSERT_EQUAL(sequential.RemoveDocuments(execution::seq, batch), removed_ids.size());
+        ASSERT_EQUAL(parallel.RemoveDocuments(execution::par, batch), removed_ids.size());
+        ASSERT_EQUAL(parallel.RemoveDocuments(batch), 0u);
+
+        for (const SearchServer* server : { &sequential, &parallel }) {
+            ASSERT_EQUAL(server->GetDocumentCount(), expected.GetDocumentCount());
+            ASSERT(vector<int>(server->begin(), server->end()) == vector<int>(expected.begin(), expected.end()));
+            for (const string& query : queries) {
+                const auto found_docs = server->FindTopDocuments(query);
+                const auto expected_docs = expected.FindTopDocuments(query);
+                ASSERT_EQUAL(found_docs.size(), expected_docs.size());
+                for (size_t i = 0; i < found_docs.size(); ++i) {
+                    ASSERT_EQUAL(found_docs[i].id, expected_docs[i].id);
+                    ASSERT_EQUAL(found_docs[i].relevance, expected_docs[i].relevance);
+                }
+            }
+            const HighFrequencyTermReport report = server->GetHighFrequencyTermReport();
+            const HighFrequencyTermReport expected_report = expected.GetHighFrequencyTermReport();
+            ASSERT_EQUAL(report.terms.size(), expected_report.terms.size());
+            for (size_t i = 0; i < report.terms.size(); ++i) {
+                ASSERT_EQUAL(report.terms[i].document_freq, expected_report.terms[i].document_freq);
+            }
+        }
+    }
+}
+
+void TestTermDictionary() {
+    // словарь растёт много раз, и все слова остаются доступны
+    vector<string> terms;
+    for (int i = 0; i < 10'000; ++i) {
+        terms.push_back("w"s + to_string(i));
+    }
+    TermDictionary dictionary;
+    for (int i = 0; i < static_cast<int>(terms.size()); ++i) {
+        dictionary.Insert(terms[i], TermDictionary::Hash(terms[i]), i);
+    }
+    ASSERT_EQUAL(dictionary.size(), terms.size());
+    for (int i = 0; i < static_cast<int>(terms.size()); ++i) {
+        ASSERT_EQUAL(dictionary.Find(terms[i]), i);
+        ASSERT_EQUAL(dictionary.Find(terms[i], TermDictionary::Hash(terms[i])), i);
+    }
+    ASSERT_EQUAL(dictionary.Find("w10000"s), TermDictionary::NOT_FOUND);
+    ASSERT_EQUAL(dictionary.Find(""s), TermDictionary::NOT_FOUND);
+    ASSERT_EQUAL(TermDictionary().Find("w0"s), TermDictionary::NOT_FOUND);
+
+    // незнакомые слова запроса ничего не находят и ничего не исключают
+    SearchServer server("and"s);
+    server.AddDocument(1, "white cat and fancy collar"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 3 });
+    ASSERT(server.FindTopDocuments("unknown words"s).empty());
+    ASSERT_EQUAL(server.FindTopDocuments("cat -unknown"s).size(), 2u);
+    ASSERT_EQUAL(server.FindTopDocuments("cat -fluffy"s).size(), 1u);
+    ASSERT_EQUAL(server.FindTopDocuments("cat -fluffy"s)[0].id, 1);
+    const auto [words_matched, status] = server.MatchDocument("fluffy tail -unknown"s, 2);
+    ASSERT_EQUAL(words_matched.size(), 2u);
+    ASSERT(status == DocumentStatus::ACTUAL);
+}
+
+void TestQueryProfile() {
+    SearchServer server("and in"s);
+    server.AddDocument(1, "white cat fancy collar"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 3 });
+    server.AddDocument(4, "fluffy dog"s, DocumentStatus::ACTUAL, { 4 });
+    const string query = "fluffy cat cat and -dog -unknown"s;
+    const auto expected = server.FindTopDocuments(query);
+    ASSERT_EQUAL(expected.size(), 2u);
+
+    const auto check_documents = [&expected](const vector<Document>& documents) {
+        ASSERT_EQUAL(documents.size(), expected.size());
+        for (size_t i = 0; i < documents.size(); ++i) {
+            ASSERT_EQUAL(documents[i].id, expected[i].id);
+            ASSERT(abs(documents[i].relevance - expected[i].relevance) < 1e-6);
+        }
+    };
+    const auto check_terms = [](const QueryProfile& profile) {
+        ASSERT_EQUAL(profile.plus_terms.size(), 2u);
+        ASSERT_EQUAL(profile.plus_terms[0].word, "cat"s);
+        ASSERT_EQUAL(profile.plus_terms[0].posting_count, 2u);
+        ASSERT_EQUAL(profile.plus_terms[1].word, "fluffy"s);
+        // слово без документов остаётся в профиле с нулевым числом вхождений
+        ASSERT_EQUAL(profile.minus_terms.size(), 2u);
+        ASSERT_EQUAL(profile.minus_terms[0].word, "dog"s);
+        ASSERT_EQUAL(profile.minus_terms[1].word, "unknown"s);
+        ASSERT_EQUAL(profile.minus_terms[1].posting_count, 0u);
+        ASSERT_EQUAL(profile.excluded_documents, 2u);
+        ASSERT_EQUAL(profile.postings_scanned, 4u);
+    };
+
+    // документов мало, и последовательное выполнение выбирает плотный аккумулятор;
+    // предикат вызывается только для найденных и не исключённых документов
+    {
+        QueryProfile profile;
+        check_documents(server.FindTopDocuments(execution::seq, query, DocumentFilter{ DocumentStatus::ACTUAL }, profile));
+        check_terms(profile);
+        ASSERT(profile.path == QueryExecutionPath::DENSE);
+        ASSERT_EQUAL(profile.predicate_calls, 2u);
+        ASSERT_EQUAL(profile.accumulator_size, 4u);
+        ASSERT_EQUAL(profile.lock_acquisitions, 0u);
+    }
+    // параллельное выполнение вызывает предикат для каждого не исключённого вхождения
+    {
+        QueryProfile profile;
+        check_documents(server.FindTopDocuments(execution::par, query, DocumentFilter{ DocumentStatus::ACTUAL }, profile));
+        check_terms(profile);
+        ASSERT(profile.path == QueryExecutionPath::PARALLEL);
+        ASSERT_EQUAL(profile.predicate_calls, 3u);
+        ASSERT_EQUAL(profile.accumulator_size, 2u);
+        // по захвату на каждое принятое вхождение и на каждую из 100 корзин при сборке
+        ASSERT_EQUAL(profile.lock_acquisitions, 103u);
+    }
+    // профиль перезаписывается целиком
+    {
+        QueryProfile profile;
+        profile.lock_acquisitions = 42;
+        check_documents(server.FindTopDocuments(query, profile));
+        check_terms(profile);
+        ASSERT(profile.path != QueryExecutionPath::IMPACT);
+        server.FindTopDocuments("unknown zebra* unknown"s, profile);
+        ASSERT_EQUAL(profile.plus_terms.size(), 2u);
+        ASSERT_EQUAL(profile.plus_terms[0].word, "unknown"s);
+        ASSERT_EQUAL(profile.plus_terms[1].word, "zebra*"s);
+        ASSERT_EQUAL(profile.plus_terms[1].posting_count, 0u);
+        ASSERT_EQUAL(profile.postings_scanned, 0u);
+        ASSERT_EQUAL(profile.predicate_calls, 0u);
+    }
+    {
+        server.BuildImpactIndex();
+        server.SetImpactSearchOptions({ true, 0 });
+        QueryProfile profile;
+        check_documents(server.FindTopDocuments(query, profile));
+        check_terms(profile);
+        ASSERT(profile.path == QueryExecutionPath::IMPACT);
+        ASSERT_EQUAL(profile.accumulator_size, 2u);
+        ASSERT(profile.score_time > chrono::nanoseconds::zero());
+        ASSERT(profile.select_time > chrono::nanoseconds::zero());
+        ostringstream out;
+        out << profile;
+        ASSERT(out.str().find("path = IMPACT"s) != string::npos);
+    }
+}
+
+void TestSharedVocabulary() {
+    const vector<string> cats = { "white cat fancy collar"s, "fluffy cat fluffy tail"s, "catalog of cats"s };
+    const vector<string> dogs = { "groomed dog expressive eyes"s, "fluffy dog"s, "dog catcher"s };
+
+    auto vocabulary = make_shared<SharedVocabulary>();
+    SearchServer shared_cats("of"s);
+    SearchServer shared_dogs("of"s);
+    shared_cats.SetSharedVocabulary(vocabulary);
+    shared_dogs.SetSharedVocabulary(vocabulary);
+    SearchServer own_cats("of"s);
+    SearchServer own_dogs("of"s);
+    // серверы с общим словарём наполняются из разных потоков
+    thread cats_thread([&] {
+        for (int id = 0; id < static_cast<int>(cats.size()); ++id) {
+            shared_cats.AddDocument(id, cats[id], DocumentStatus::ACTUAL, { id });
+        }
+    });
+    thread dogs_thread([&] {
+        for (int id = 0; id < static_cast<int>(dogs.size()); ++id) {
+            shared_dogs.AddDocument(id, dogs[id], DocumentStatus::ACTUAL, { id });
+        }
+    });
+    cats_thread.join();
+    dogs_thread.join();
+    for (int id = 0; id < 3; ++id) {
+        own_cats.AddDocument(id, cats[id], DocumentStatus::ACTUAL, { id });
+        own_dogs.AddDocument(id, dogs[id], DocumentStatus::ACTUAL, { id });
+    }
+
+    // fluffy и каждое другое общее слово хранится один раз
+    ASSERT_EQUAL(vocabulary->size(), 13u);
+    ASSERT(vocabulary->Find("fluffy"s) != TermDictionary::NOT_FOUND);
+    ASSERT_EQUAL(vocabulary->GetWord(vocabulary->Find("catcher"s)), "catcher"sv);
+    ASSERT_EQUAL(vocabulary->Find("of"s), TermDictionary::NOT_FOUND);
+
+    for (const string& query : { "fluffy"s, "cat -fluffy"s, "dog catcher"s, "cat*"s, "~dog"s, "cats -cat*"s }) {
+        for (const auto& [shared_server, own_server] : { pair{ &shared_cats, &own_cats }, pair{ &shared_dogs, &own_dogs } }) {
+            const auto shared_documents = shared_server->FindTopDocuments(query);
+            const auto own_documents = own_server->FindTopDocuments(query);
+            ASSERT_EQUAL_HINT(shared_documents.size(), own_documents.size(), query);
+            for (size_t i = 0; i < shared_documents.size(); ++i) {
+                ASSERT_EQUAL(shared_documents[i].id, own_documents[i].id);
+                ASSERT(abs(shared_documents[i].relevance - own_documents[i].relevance) < 1e-6);
+            }
+        }
+    }
+    const auto [words, status] = shared_dogs.MatchDocument("cat* fluffy"s, 2);
+    ASSERT_EQUAL(words.size(), 1u);
+    ASSERT_EQUAL(words[0], "catcher"sv);
+
+    // ограничение числа раскрытий относится только к словам своего сервера
+    shared_dogs.SetTermExpansionOptions({ 1, 1 });
+    const auto catchers = shared_dogs.FindTopDocuments("cat*"s);
+    ASSERT_EQUAL(catchers.size(), 1u);
+    ASSERT_EQUAL(catchers[0].id, 2);
+
+    try {
+        own_cats.SetSharedVocabulary(vocabulary);
+        ASSERT_HINT(false, "Vocabulary must be set before documents are added"s);
+    }
+    catch (const invalid_argument&) {
+    }
+}
+
+void TestLongQueries() {
+    SearchServer server("and"s);
+    server.AddDocument(1, "white cat and fancy collar"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 3 });
+    server.AddDocument(4, "fluffy dog with collar"s, DocumentStatus::ACTUAL, { 4 });
+    server.AddDocument(5, "white cat fancy tail"s, DocumentStatus::BANNED, { 5 });
+
+    // без ограничения запрос из документа находит все документы с его словами
+    const string long_query = "white cat fancy collar fluffy tail groomed dog"s;
+    ASSERT_EQUAL(server.FindTopDocuments(long_query).size(), 4u);
+
+    // остаются три слова с наибольшим весом: повторённое fluffy и два из самых редких
+    server.SetLongQueryOptions({ 3, 0.0 });
+    QueryPlan plan = server.ExplainQuery(long_query + " fluffy fluffy"s);
+    ASSERT_EQUAL(plan.plus_terms.size(), 3u);
+    ASSERT(any_of(plan.plus_terms.begin(), plan.plus_terms.end(), [](const PlannedTerm& term) { return term.word == "fluffy"sv; }));
+    ASSERT(all_of(plan.plus_terms.begin(), plan.plus_terms.end(), [](const PlannedTerm& term) { return term.word != "cat"sv; }));
+    // короткий запрос не сокращается
+    ASSERT_EQUAL(server.ExplainQuery("cat dog"s).plus_terms.size(), 2u);
+
+    // слова с малым IDF отбрасываются, даже если мест хватает
+    server.SetLongQueryOptions({ 3, log(5.0 / 2) + 1e-9 });
+    plan = server.ExplainQuery(long_query);
+    ASSERT_EQUAL(plan.plus_terms.size(), 1u);
+    ASSERT_EQUAL(plan.plus_terms[0].word, "groomed"sv);
+    server.SetLongQueryOptions({});
+
+    // похожие документы ищутся по словам документа, сам документ не входит в результат
+    const auto similar = server.FindSimilar(1);
+    ASSERT_EQUAL(similar.size(), 2u);
+    ASSERT_EQUAL(similar[0].id, 4);
+    ASSERT_EQUAL(similar[1].id, 2);
+    const auto banned_similar = server.FindSimilar(1, DocumentFilter{ DocumentStatus::BANNED });
+    ASSERT_EQUAL(banned_similar.size(), 1u);
+    ASSERT_EQUAL(banned_similar[0].id, 5);
+    ASSERT(server.FindSimilar(3, DocumentFilter{ DocumentStatus::ACTUAL, 5 }).empty());
+
+    server.SetLongQueryOptions({ 1, 0.0 });
+    const auto nearest = server.FindSimilar(2);
+    ASSERT_EQUAL(nearest.size(), 1u);
+    ASSERT_EQUAL(nearest[0].id, 4);
+
+    try {
+        server.FindSimilar(42);
+        ASSERT_HINT(false, "Missing document must be rejected"s);
+    }
+    catch (const out_of_range&) {
+    }
+}
+
+void TestStandingQueries() {
+    SearchServer server("and in"s);
+    server.AddStandingQuery(10, "fluffy cat"s);
+    server.AddStandingQuery(11, "cat -collar"s);
+    server.AddStandingQuery(12, "groomed and expressive dog"s);
+    server.AddStandingQuery(13, "parrot"s);
+
+    vector<pair<int, vector<StandingQueryMatch>>> notifications;
+    server.SetStandingQueryCallback([&notifications](int document_id, vector<StandingQueryMatch> matches) {
+        sort(matches.begin(), matches.end(), [](const StandingQueryMatch& lhs, const StandingQueryMatch& rhs) {
+            return lhs.query_id < rhs.query_id;
+        });
+        notifications.emplace_back(document_id, matches);
+    });
+    server.AddDocument(1, "white cat and fancy collar"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 3 });
+    server.AddDocument(4, "white mouse"s, DocumentStatus::ACTUAL, { 4 });
+
+    // документ 4 не подходит ни одному запросу, и вызова для него нет
+    ASSERT_EQUAL(notifications.size(), 3u);
+    ASSERT_EQUAL(notifications[0].first, 1);
+    ASSERT_EQUAL(notifications[0].second.size(), 1u);
+    ASSERT_EQUAL(notifications[0].second[0].query_id, 10);
+    ASSERT_EQUAL(notifications[1].first, 2);
+    ASSERT_EQUAL(notifications[1].second.size(), 2u);
+    ASSERT_EQUAL(notifications[1].second[0].query_id, 10);
+    ASSERT_EQUAL(notifications[1].second[1].query_id, 11);
+    ASSERT_EQUAL(notifications[2].first, 3);
+    ASSERT_EQUAL(notifications[2].second[0].query_id, 12);
+
+    // релевантность та же, что у FindTopDocuments по тексту сохранённого запроса
+    for (const auto& [query_id, query] : { pair{ 10, "fluffy cat"s }, pair{ 11, "cat -collar"s }, pair{ 12, "groomed dog expressive"s } }) {
+        for (const Document& document : server.FindTopDocuments(query)) {
+            const auto matches = server.MatchStandingQueries(document.id);
+            const auto match = find_if(matches.begin(), matches.end(), [query_id = query_id](const StandingQueryMatch& match) {
+                return match.query_id == query_id;
+            });
+            ASSERT_HINT(match != matches.end(), query);
+            ASSERT(abs(match->relevance - document.relevance) < 1e-6);
+        }
+    }
+    ASSERT(server.MatchStandingQueries(4).empty());
+
+    ASSERT(server.RemoveStandingQuery(10));
+    ASSERT(!server.RemoveStandingQuery(10));
+    server.AddDocument(5, "fluffy parrot"s, DocumentStatus::ACTUAL, { 5 });
+    ASSERT_EQUAL(notifications.size(), 4u);
+    ASSERT_EQUAL(notifications[3].second.size(), 1u);
+    ASSERT_EQUAL(notifications[3].second[0].query_id, 13);
+
+    for (const string& invalid_query : { "cat*"s, "~cat"s, "and -dog"s }) {
+        try {
+            server.AddStandingQuery(20, invalid_query);
+            ASSERT_HINT(false, invalid_query);
+        }
+        catch (const invalid_argument&) {
+        }
+    }
+    try {
+        server.AddStandingQuery(11, "dog"s);
+        ASSERT_HINT(false, "Standing query ids must be unique"s);
+    }
+    catch (const invalid_argument&) {
+    }
+
+    // слова запросов попадают в словарь только вместе с первым содержащим их документом
+    auto vocabulary = make_shared<SharedVocabulary>();
+    SearchServer shared_server("and"s);
+    shared_server.SetSharedVocabulary(vocabulary);
+    shared_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+    shared_server.AddStandingQuery(1, "cat -collar"s);
+    shared_server.AddStandingQuery(2, "parrot"s);
+    shared_server.AddStandingQuery(3, "hamster"s);
+    ASSERT_EQUAL(vocabulary->size(), 2u);
+    ASSERT(shared_server.RemoveStandingQuery(3));
+    shared_server.AddDocument(2, "white cat and collar"s, DocumentStatus::ACTUAL, { 2 });
+    shared_server.AddDocument(3, "green parrot"s, DocumentStatus::ACTUAL, { 3 });
+    shared_server.AddDocument(4, "hamster"s, DocumentStatus::ACTUAL, { 4 });
+    ASSERT(shared_server.MatchStandingQueries(2).empty());
+    ASSERT_EQUAL(shared_server.MatchStandingQueries(3).size(), 1u);
+    ASSERT_EQUAL(shared_server.MatchStandingQueries(3)[0].query_id, 2);
+    ASSERT(shared_server.MatchStandingQueries(4).empty());
+}
+
+void TestReadReplica() {
+    const string socket_path = (filesystem::temp_directory_path() / "search_server_test.sock"s).string();
+    const auto timeout = chrono::seconds(5);
+    SearchServer writer("in the"s);
+    writer.OpenMutationPublisher(socket_path, { 1 << 20, chrono::milliseconds(1) });
+    writer.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, { 1, 2, 3 });
+    writer.AddDocument(2, "dog in the village"s, DocumentStatus::BANNED, { -4 });
+    writer.AddDocument(3, "cat and dog"s, DocumentStatus::ACTUAL, { 5 });
+    writer.RemoveDocument(3);
+    ASSERT_EQUAL(writer.GetMutationSequence(), 4u);
+
+    SearchServer replica_server("in the"s);
+    ReadReplica replica(replica_server, socket_path);
+    ASSERT(replica.WaitForSequence(writer.GetMutationSequence(), timeout));
+    ASSERT_EQUAL(replica.GetAppliedSequence(), 4u);
+    replica.Read(4, timeout, [](const SearchServer& server) {
+        ASSERT_EQUAL(server.GetDocumentCount(), 2);
+        const auto found_docs = server.FindTopDocuments("dog"s, DocumentStatus::BANNED);
+        ASSERT_EQUAL(found_docs.size(), 1u);
+        ASSERT_EQUAL(found_docs[0].id, 2);
+        ASSERT_EQUAL(found_docs[0].rating, -4);
+    });
+
+    // второй сервер подключается позже и получает изменения, сохранённые издателем
+    SearchServer late_server;
+    ReadReplica late_replica(late_server, socket_path);
+    writer.AddDocument(4, "parrot in the cage"s, DocumentStatus::ACTUAL, { 2 });
+    const uint64_t sequence = writer.GetMutationSequence();
+    const auto found_parrots = late_replica.Read(sequence, timeout, [](const SearchServer& server) {
+        return server.FindTopDocuments("parrot"s);
+    });
+    ASSERT_EQUAL(found_parrots.size(), 1u);
+    ASSERT_EQUAL(found_parrots[0].id, 4);
+    ASSERT(replica.WaitForSequence(sequence, timeout));
+    ASSERT_EQUAL(writer.GetMutationPublisherStats().followers, 2u);
+
+    try {
+        replica.Read(sequence + 1, chrono::milliseconds(20), [](const SearchServer&) {});
+        ASSERT_HINT(false, "Reads must wait for the requested sequence"s);
+    }
+    catch (const out_of_range&) {
+    }
+    try {
+        writer.OpenMutationPublisher(socket_path);
+        ASSERT_HINT(false, "Mutation publisher can be opened only once"s);
+    }
+    catch (const invalid_argument&) {
+    }
+
+    // пустые слова доходят до реплики без изменений
+    writer.AddDocument(6, " cat  dog "s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT(replica.WaitForSequence(writer.GetMutationSequence(), timeout));
+    const auto to_map = [](const auto& word_freqs) {
+        map<string, double> result;
+        for (const auto [word, freq] : word_freqs) {
+            result[string(word)] = freq;
+        }
+        return result;
+    };
+    replica.Read(writer.GetMutationSequence(), timeout, [&writer, &to_map](const SearchServer& server) {
+        ASSERT(to_map(server.GetWordFrequencies(6)) == to_map(writer.GetWordFrequencies(6)));
+        ASSERT_EQUAL(to_map(server.GetWordFrequencies(6)).size(), 3u);
+    });
+
+    // издатель не удаляет по своему пути файлы, которые не являются сокетами
+    const string file_path = (filesystem::temp_directory_path() / "search_server_test.txt"s).string();
+    ofstream(file_path) << "data"s;
+    try {
+        MutationPublisher publisher(file_path);
+        ASSERT_HINT(false, "Mutation publisher must not replace regular files"s);
+    }
+    catch (const invalid_argument&) {
+    }
+    ASSERT(filesystem::exists(file_path));
+    filesystem::remove(file_path);
+
+    // Изменение, которое реплика не может применить, останавливает её, и ошибка
+    // доходит до читателей. Пока изменений нет, сервер реплики меняется напрямую,
+    // чтобы следующее добавление документа 5 не прошло
+    ASSERT(replica.GetError() == nullptr);
+    replica_server.AddDocument(5, "hamster"s, DocumentStatus::ACTUAL, { 1 });
+    writer.AddDocument(5, "green parrot"s, DocumentStatus::ACTUAL, { 1 });
+    try {
+        replica.WaitForSequence(writer.GetMutationSequence(), timeout);
+        ASSERT_HINT(false, "Replica must report failed mutations"s);
+    }
+    catch (const invalid_argument&) {
+    }
+    ASSERT(replica.GetError() != nullptr);
+    ASSERT_EQUAL(replica.GetAppliedSequence(), sequence + 1);
+    try {
+        replica.Read(sequence, timeout, [](const SearchServer&) {});
+        ASSERT_HINT(false, "Reads from a failed replica must throw"s);
+    }
+    catch (const invalid_argument&) {
+    }
+    ASSERT(late_replica.WaitForSequence(writer.GetMutationSequence(), timeout));
+}
 
 // Функция TestSearchServer является точкой входа для запуска тестов
 void TestSearchServer() {
     RUN_TEST(TestExcludeStopWordsFromAddedDocumentContent);
     RUN_TEST(TestExcludeDocumentsWithMinusWords);
     RUN_TEST(TestMatchDocument);
+    RUN_TEST(TestMatchDocuments);
     RUN_TEST(TestAverageRatingDocument);
     RUN_TEST(TestRelevanceDocument);
     RUN_TEST(TestChoiseOfStatusDocument);
     RUN_TEST(TestPredicatFunction);
+    RUN_TEST(TestDocumentFilter);
+    RUN_TEST(TestQueryPlan);
+    RUN_TEST(TestTermExpansion);
+    RUN_TEST(TestRemoveDuplicates);
+    RUN_TEST(TestCursorPagination);
+    RUN_TEST(TestAdaptiveExecution);
+    RUN_TEST(TestQueryArena);
+    RUN_TEST(TestImpactOrderedSearch);
+    RUN_TEST(TestLoadCorpus);
+    RUN_TEST(TestWriteAheadLog);
+    RUN_TEST(TestWordFrequencies);
+    RUN_TEST(TestCompactSearchTraits);
+    RUN_TEST(TestScoreKernels);
+    RUN_TEST(TestBatchQueries);
+    RUN_TEST(TestLoadTest);
+    RUN_TEST(TestDocumentOrdinals);
+    RUN_TEST(TestHighFrequencyTerms);
+    RUN_TEST(TestRemoveDocuments);
+    RUN_TEST(TestTermDictionary);
+    RUN_TEST(TestQueryProfile);
+    RUN_TEST(TestSharedVocabulary);
+    RUN_TEST(TestLongQueries);
+    RUN_TEST(TestStandingQueries);
+    RUN_TEST(TestReadReplica);
     RUN_TEST(TestAddDocument);
 }
\ No newline at end of file
@@ -1,5 +1,11 @@
 #pragma once
 #include "search_server.h"
+#include "search_pages.h"
+#include "benchmark_functions.h"
+#include "corpus_loader.h"
+#include "load_generator.h"
+#include "process_queries.h"
+#include "read_replica.h"
 
 template <typename T, typename U>
 void AssertEqualImpl(const T& t, const U& u, const string& t_str, const string& u_str, const string& file,
@@ -24,8 +30,33 @@ void TestAddDocument();
 void TestExcludeStopWordsFromAddedDocumentContent();
 void TestExcludeDocumentsWithMinusWords();
 void TestMatchDocument();
+void TestMatchDocuments();
 void TestRelevanceDocument();
 void TestAverageRatingDocument();
 void TestPredicatFunction();
 void TestChoiseOfStatusDocument();
+void TestDocumentFilter();
+void TestQueryPlan();
+void TestTermExpansion();
+void TestRemoveDuplicates();
+void TestCursorPagination();
+void TestAdaptiveExecution();
+void TestQueryArena();
+void TestImpactOrderedSearch();
+void TestLoadCorpus();
+void TestWriteAheadLog();
+void TestWordFrequencies();
+void TestCompactSearchTraits();
+void TestScoreKernels();
+void TestBatchQueries();
+void TestLoadTest();
+void TestDocumentOrdinals();
+void TestHighFrequencyTerms();
+void TestRemoveDocuments();
+void TestTermDictionary();
+void TestQueryProfile();
+void TestSharedVocabulary();
+void TestLongQueries();
+void TestStandingQueries();
+void TestReadReplica();
 void TestSearchServer();
\ No newline at end of file
@@ -0,0 +1,308 @@
+#include "write_ahead_log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mapped_file.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+const size_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+template <typename T>
+void WriteValue(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool ReadValue(std::string_view& in, T& value) {
+    if (in.size() < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, in.data(), sizeof(value));
+    in.remove_prefix(sizeof(value));
+    return true;
+}
+
+void AppendFrame(std::string& out, const std::string& payload) {
+    WriteValue(out, static_cast<uint32_t>(payload.size()));
+    WriteValue(out, ComputeWalChecksum(payload));
+    out += payload;
+}
+
+void WriteAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t written = write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::invalid_argument("Cannot write to write-ahead log: "s + std::strerror(errno));
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+}
+
+}
+
+uint32_t ComputeWalChecksum(std::string_view data) {
+    uint32_t hash = 2166136261u;
+    for (const char c : data) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+std::string EncodeWalAdd(uint32_t document_id, const std::vector<std::string_view>& words, DocumentStatus status, const std::vector<int>& ratings) {
+    std::string payload;
+    WriteValue(payload, static_cast<uint8_t>(WalRecordType::ADD_DOCUMENT));
+    WriteValue(payload, document_id);
+    WriteValue(payload, static_cast<uint8_t>(status));
+    WriteValue(payload, static_cast<uint32_t>(ratings.size()));
+    for (const int rating : ratings) {
+        WriteValue(payload, static_cast<int32_t>(rating));
+    }
+    // Число слов хранится отдельно, а пробел ставится перед каждым словом после первого,
+    // поэтому пустые слова в начале, в конце и подряд не теряются
+    WriteValue(payload, static_cast<uint32_t>(words.size()));
+    const size_t text_size_offset = payload.size();
+    WriteValue(payload, uint32_t{ 0 });
+    for (size_t i = 0; i < words.size(); ++i) {
+        if (i > 0) {
+            payload.push_back(' ');
+        }
+        payload.append(words[i]);
+    }
+    const uint32_t text_size = static_cast<uint32_t>(payload.size() - text_size_offset - sizeof(uint32_t));
+    std::memcpy(payload.data() + text_size_offset, &text_size, sizeof(text_size));
+    return payload;
+}
+
+std::string EncodeWalRemove(uint32_t document_id) {
+    std::string payload;
+    WriteValue(payload, static_cast<uint8_t>(WalRecordType::REMOVE_DOCUMENT));
+    WriteValue(payload, document_id);
+    return payload;
+}
+
+bool ParseWalRecord(std::string_view payload, WalRecord& record) {
+    uint8_t type = 0;
+    uint32_t document_id = 0;
+    if (!ReadValue(payload, type) || !ReadValue(payload, document_id)) {
+        return false;
+    }
+    record.type = static_cast<WalRecordType>(type);
+    record.document_id = document_id;
+    record.ratings.clear();
+    record.words.clear();
+    if (record.type == WalRecordType::REMOVE_DOCUMENT) {
+        return payload.empty();
+    }
+    if (record.type != WalRecordType::ADD_DOCUMENT) {
+        return false;
+    }
+
+    uint8_t status = 0;
+    uint32_t rating_count = 0;
+    if (!ReadValue(payload, status) || status > static_cast<uint8_t>(DocumentStatus::REMOVED)
+        || !ReadValue(payload, rating_count) || payload.size() / sizeof(int32_t) < rating_count) {
+        return false;
+    }
+    record.status = static_cast<DocumentStatus>(status);
+    record.ratings.resize(rating_count);
+    for (int& rating : record.ratings) {
+        int32_t value = 0;
+        ReadValue(payload, value);
+        rating = value;
+    }
+    uint32_t word_count = 0;
+    uint32_t text_size = 0;
+    if (!ReadValue(payload, word_count) || !ReadValue(payload, text_size) || payload.size() != text_size) {
+        return false;
+    }
+    if (word_count == 0) {
+        return payload.empty();
+    }
+    // в теле word_count - 1 пробелов
+    for (size_t separator = payload.find(' '); separator != std::string_view::npos; separator = payload.find(' ')) {
+        record.words.push_back(payload.substr(0, separator));
+        payload.remove_prefix(separator + 1);
+    }
+    record.words.push_back(payload);
+    return record.words.size() == word_count;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& path, size_t valid_size, const WriteAheadLogOptions& options)
+    : options_(options)
+    , synced_size_(valid_size)
+{
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd_ < 0) {
+        throw std::invalid_argument("Cannot open write-ahead log "s + path);
+    }
+    if (ftruncate(fd_, static_cast<off_t>(valid_size)) != 0) {
+        close(fd_);
+        throw std::invalid_argument("Cannot truncate write-ahead log "s + path);
+    }
+    flusher_ = std::thread([this] { RunFlusher(); });
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard lock(buffer_mutex_);
+        stopping_ = true;
+    }
+    flush_requested_.notify_one();
+    flusher_.join();
+    try {
+        Flush();
+    } catch (...) {
+    }
+    close(fd_);
+}
+
+void WriteAheadLog::AppendAdd(uint32_t document_id, const std::vector<std::string_view>& words, DocumentStatus status, const std::vector<int>& ratings) {
+    std::string records;
+    AppendFrame(records, EncodeWalAdd(document_id, words, status, ratings));
+    Append(records, 1);
+}
+
+void WriteAheadLog::AppendRemove(uint32_t document_id) {
+    AppendRemoves({ document_id });
+}
+
+void WriteAheadLog::AppendRemoves(const std::vector<uint32_t>& document_ids) {
+    std::string records;
+    for (const uint32_t document_id : document_ids) {
+        AppendFrame(records, EncodeWalRemove(document_id));
+    }
+    Append(records, document_ids.size());
+}
+
+// Полный буфер сбрасывается до добавления записей: если сброс не удался, записи не
+// попадают в журнал и вызывающий ещё не успел изменить индекс
+void WriteAheadLog::Append(const std::string& records, size_t record_count) {
+    bool is_full = false;
+    {
+        std::lock_guard lock(buffer_mutex_);
+        if (failure_) {
+            std::rethrow_exception(failure_);
+        }
+        is_full = !buffer_.empty() && buffer_.size() + records.size() >= options_.group_commit_bytes;
+    }
+    if (is_full) {
+        Flush();
+    }
+    std::lock_guard lock(buffer_mutex_);
+    buffer_ += records;
+    stats_.records += record_count;
+}
+
+void WriteAheadLog::Flush() {
+    std::lock_guard file_lock(file_mutex_);
+    std::string pending;
+    {
+        std::lock_guard lock(buffer_mutex_);
+        if (failure_) {
+            std::rethrow_exception(failure_);
+        }
+        pending.swap(buffer_);
+    }
+    if (pending.empty()) {
+        return;
+    }
+    try {
+        WriteAll(fd_, pending);
+        if (fdatasync(fd_) != 0) {
+            throw std::invalid_argument("Cannot sync write-ahead log: "s + std::strerror(errno));
+        }
+    } catch (...) {
+        // Недописанный хвост скрыл бы при воспроизведении все записи после него, поэтому
+        // файл возвращается к последнему сброшенному размеру, а записи — в начало буфера.
+        // Если и это не удалось, журнал больше не принимает записей
+        const bool is_truncated = ftruncate(fd_, static_cast<off_t>(synced_size_)) == 0;
+        std::lock_guard lock(buffer_mutex_);
+        buffer_.insert(0, pending);
+        if (!is_truncated) {
+            failure_ = std::current_exception();
+        }
+        throw;
+    }
+    synced_size_ += pending.size();
+    std::lock_guard lock(buffer_mutex_);
+    stats_.bytes += pending.size();
+    ++stats_.syncs;
+}
+
+void WriteAheadLog::RunFlusher() {
+    std::unique_lock lock(buffer_mutex_);
+    while (!stopping_) {
+        flush_requested_.wait_for(lock, options_.group_commit_interval);
+        if (!buffer_.empty() && !stopping_) {
+            lock.unlock();
+            try {
+                Flush();
+            } catch (...) {
+                // записи остались в буфере; ошибка повторится и будет выброшена при следующем
+                // Sync или сбросе по размеру
+            }
+            lock.lock();
+        }
+    }
+}
+
+void WriteAheadLog::Sync() {
+    Flush();
+}
+
+void WriteAheadLog::Truncate() {
+    std::lock_guard file_lock(file_mutex_);
+    std::lock_guard lock(buffer_mutex_);
+    buffer_.clear();
+    if (ftruncate(fd_, 0) != 0 || fdatasync(fd_) != 0) {
+        failure_ = std::make_exception_ptr(std::invalid_argument("Cannot truncate write-ahead log: "s + std::strerror(errno)));
+        std::rethrow_exception(failure_);
+    }
+    synced_size_ = 0;
+    failure_ = nullptr;
+}
+
+WriteAheadLogStats WriteAheadLog::GetStats() const {
+    std::lock_guard lock(buffer_mutex_);
+    return stats_;
+}
+
+size_t WriteAheadLog::Replay(const std::string& path, const std::function<void(const WalRecord&)>& visitor) {
+    if (!std::filesystem::exists(path) || std::filesystem::file_size(path) == 0) {
+        return 0;
+    }
+    const MappedFile file(path);
+    const std::string_view data = file.GetData();
+
+    WalRecord record;
+    size_t offset = 0;
+    while (data.size() - offset >= RECORD_HEADER_SIZE) {
+        std::string_view header = data.substr(offset, RECORD_HEADER_SIZE);
+        uint32_t payload_size = 0;
+        uint32_t checksum = 0;
+        ReadValue(header, payload_size);
+        ReadValue(header, checksum);
+        if (data.size() - offset - RECORD_HEADER_SIZE < payload_size) {
+            break;
+        }
+        const std::string_view payload = data.substr(offset + RECORD_HEADER_SIZE, payload_size);
+        if (ComputeWalChecksum(payload) != checksum || !ParseWalRecord(payload, record)) {
+            break;
+        }
+        visitor(record);
+        offset += RECORD_HEADER_SIZE + payload_size;
+    }
+    return offset;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "document.h"
+
+// Записи копятся в буфере и сбрасываются на диск одним write и fdatasync, когда
+// буфер дорастает до group_commit_bytes или с последнего сброса прошло
+// group_commit_interval. При сбое теряется не больше этого окна.
+struct WriteAheadLogOptions {
+    size_t group_commit_bytes = 1 << 20;
+    std::chrono::milliseconds group_commit_interval{ 10 };
+};
+
+struct WriteAheadLogStats {
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t syncs = 0;
+};
+
+enum class WalRecordType : uint8_t {
+    ADD_DOCUMENT = 1,
+    REMOVE_DOCUMENT = 2,
+};
+
+struct WalRecord {
+    WalRecordType type = WalRecordType::ADD_DOCUMENT;
+    uint32_t document_id = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+    // слова документа, включая пустые; указывают внутрь тела записи и действительны
+    // только внутри обработчика Replay или обработчика пачки MutationSubscriber
+    std::vector<std::string_view> words;
+};
+
+// Тела записей журнала. Тем же форматом передаются изменения репликам (см. mutation_stream.h)
+std::string EncodeWalAdd(uint32_t document_id, const std::vector<std::string_view>& words, DocumentStatus status, const std::vector<int>& ratings);
+std::string EncodeWalRemove(uint32_t document_id);
+// words записи указывают внутрь payload; false, если тело повреждено
+bool ParseWalRecord(std::string_view payload, WalRecord& record);
+uint32_t ComputeWalChecksum(std::string_view data);
+
+// Двоичный журнал только для дописывания: каждая запись — длина, контрольная сумма
+// и тело. Недописанный или повреждённый хвост, оставшийся после сбоя, при чтении
+// отбрасывается.
+class WriteAheadLog {
+public:
+    // Открывает журнал на дописывание, предварительно обрезав его до valid_size байт,
+    // которые вернул Replay
+    WriteAheadLog(const std::string& path, size_t valid_size, const WriteAheadLogOptions& options = {});
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    void AppendAdd(uint32_t document_id, const std::vector<std::string_view>& words, DocumentStatus status, const std::vector<int>& ratings);
+    void AppendRemove(uint32_t document_id);
+    // Все записи добавляются в буфер одним куском или, при ошибке, ни одна
+    void AppendRemoves(const std::vector<uint32_t>& document_ids);
+
+    // Дожидается, пока все добавленные записи окажутся на диске
+    void Sync();
+    // Удаляет все записи; вызывается после того, как состояние сохранено в другом месте
+    void Truncate();
+
+    WriteAheadLogStats GetStats() const;
+
+    // Передаёт visitor все целые записи журнала по порядку и возвращает их общий размер
+    static size_t Replay(const std::string& path, const std::function<void(const WalRecord&)>& visitor);
+
+private:
+    const WriteAheadLogOptions options_;
+    int fd_ = -1;
+
+    mutable std::mutex buffer_mutex_;
+    std::condition_variable flush_requested_;
+    std::string buffer_;
+    bool stopping_ = false;
+    WriteAheadLogStats stats_;
+    // ошибка, после которой файл не удалось вернуть к целым записям; выбрасывается
+    // при каждом следующем добавлении и сбросе
+    std::exception_ptr failure_;
+
+    // упорядочивает запись сброшенных буферов в файл
+    std::mutex file_mutex_;
+    // размер файла после последнего успешного сброса
+    uint64_t synced_size_ = 0;
+
+    std::thread flusher_;
+
+    void Append(const std::string& records, size_t record_count);
+    void Flush();
+    void RunFlusher();
+};